@@ -0,0 +1,53 @@
+#pragma once
+#include <raylib.h>
+#include <cstdio>
+#include "piece.h"
+
+// All twelve piece sprites in one image, one fixed-size cell per piece code in
+// Piece order, each sprite centred in its cell. Drawing every piece from the same
+// texture lets raylib batch the whole board into one draw call, and startup decodes
+// a single PNG. Images/pieces_atlas.png is shipped pre-built; if it is missing it is
+// assembled from the individual sprites and written back for the next start.
+const int AtlasCellWidth = 144;  // Widest sprite (the queen, 141px) rounded up
+const int AtlasCellHeight = 128;
+const char* const PieceAtlasFile = "pieces_atlas.png";
+
+// Board colours shared by the GUI and the headless renderer; a8 is a light square
+const Color LightSquareColor = LIGHTGRAY;
+const Color DarkSquareColor = DARKGREEN;
+
+inline Rectangle AtlasSource(Piece p) {
+    return {float(p * AtlasCellWidth), 0, float(AtlasCellWidth), float(AtlasCellHeight)};
+}
+
+inline Image BuildPieceAtlas(const char* dir) {
+    static const char* const names[PieceCount] = {
+        "w_pawn", "w_knight", "w_bishop", "w_rook", "w_queen", "w_king",
+        "b_pawn", "b_knight", "b_bishop", "b_rook", "b_queen", "b_king",
+    };
+    Image atlas = GenImageColor(PieceCount * AtlasCellWidth, AtlasCellHeight, BLANK);
+    for (int p = 0; p < PieceCount; p++) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s_png_128px.png", dir, names[p]);
+        Image sprite = LoadImage(path);
+        Rectangle source = {0, 0, float(sprite.width), float(sprite.height)};
+        Rectangle dest = {float(p * AtlasCellWidth + (AtlasCellWidth - sprite.width) / 2),
+                          float((AtlasCellHeight - sprite.height) / 2), float(sprite.width), float(sprite.height)};
+        ImageDraw(&atlas, sprite, source, dest, WHITE);
+        UnloadImage(sprite);
+    }
+    return atlas;
+}
+
+inline Image LoadPieceAtlas(const char* dir) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, PieceAtlasFile);
+    if (FileExists(path)) {
+        Image atlas = LoadImage(path);
+        if (atlas.width == PieceCount * AtlasCellWidth && atlas.height == AtlasCellHeight) return atlas;
+        UnloadImage(atlas);
+    }
+    Image atlas = BuildPieceAtlas(dir);
+    ExportImage(atlas, path); // Best effort: a read-only directory just rebuilds next time
+    return atlas;
+}
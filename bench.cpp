@@ -0,0 +1,408 @@
+// Search benchmark over a fixed position set.
+// Build: g++ -O2 -std=c++17 bench.cpp -o bench -pthread
+//
+//   bench [--threads N] [--depth D] [--hash MB]   search every position to depth D
+//         [--net FILE|builtin]                    ... evaluating with an NNUE network
+//   bench --scaling [--max-threads N] [--depth D] nodes/sec and time-to-depth speedup
+//                                                 for 1, 2, 4, 8... threads
+//   bench --pgn FILE                              stream a PGN file through the rules, moves/sec
+//   bench --eval                                  static evaluations/sec
+//   bench --pawns                                 pawn-structure analysis with and without the pawn hash
+//   bench --nnue [FILE]                           NNUE evaluations/sec per SIMD path (built-in net
+//                                                 unless FILE is given)
+//   bench --write-net FILE                        save the built-in NNUE net
+//   bench --book BOOK                             Polyglot book lookups/sec
+//   bench --make-book PGN OUT                     build a Polyglot book from a PGN file
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "eval.h"
+#include "fen.h"
+#include "nnue.h"
+#include "pgn.h"
+#include "polyglot.h"
+#include "search.h"
+
+const char* const BenchPositions[] = {
+    StartFen,
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+    "r2q1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2Q1RK1 w - - 0 9",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+    "8/8/1p2k3/p1p1p3/P1P1P3/1P2K3/8/8 w - - 0 1",
+};
+
+struct BenchTotals {
+    uint64_t nodes = 0;
+    double seconds = 0;
+    uint64_t pawnHits = 0;
+    uint64_t pawnMisses = 0;
+};
+
+BenchTotals RunBench(int threads, int depth, size_t hashMb, bool verbose, const NnueNetwork* net) {
+    TranspositionTable tt(hashMb);
+    SearchPool pool(tt, threads);
+    pool.SetNetwork(net);
+    SearchLimits limits;
+    limits.depth = depth;
+    BenchTotals totals;
+
+    for (const char* fen : BenchPositions) {
+        Position pos;
+        ParseFen(fen, pos);
+        tt.Clear();
+        auto start = std::chrono::steady_clock::now();
+        SearchResult result = pool.Search(pos, {pos.key}, limits);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        totals.nodes += result.nodes;
+        totals.seconds += seconds;
+        if (verbose) {
+            printf("%-6s %6d cp  %10llu nodes  %7.3fs  %s\n", MoveToUci(result.bestMove).c_str(),
+                   result.score, (unsigned long long)result.nodes, seconds, fen);
+        }
+    }
+    pool.PawnStats(totals.pawnHits, totals.pawnMisses);
+    return totals;
+}
+
+// Replay every game of a PGN file; returns the process exit code
+int RunPgnBench(const char* path) {
+    PgnReader reader;
+    if (!reader.Open(path)) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return 2;
+    }
+    PgnGame game;
+    uint64_t games = 0, moves = 0, errors = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (reader.Next(game)) {
+        games++;
+        moves += game.game.moves.size();
+        if (!game.error.empty()) errors++;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (seconds <= 0) seconds = 1e-9;
+    printf("Games: %llu  Moves: %llu  Errors: %llu  Time: %.3fs  Moves/sec: %.0f\n",
+           (unsigned long long)games, (unsigned long long)moves, (unsigned long long)errors, seconds,
+           moves / seconds);
+    return 0;
+}
+
+// Positions from short pseudo-random games out of every bench position, with the
+// incremental piece-square score checked against a full recount along the way
+bool CollectEvalPositions(std::vector<Position>& positions) {
+    uint64_t seed = 1;
+    for (const char* fen : BenchPositions) {
+        for (int game = 0; game < 200; game++) {
+            Position pos;
+            ParseFen(fen, pos);
+            for (int ply = 0; ply < 60; ply++) {
+                MoveList moves;
+                GenerateMoves(pos, moves);
+                if (moves.Size() == 0) break;
+                UndoInfo undo;
+                MakeMove(pos, moves[int(SplitMix64(seed) % moves.Size())], undo);
+                if (pos.psq != pos.ComputePsq()) {
+                    fprintf(stderr, "Incremental score mismatch: %s\n", WriteFen(pos).c_str());
+                    return false;
+                }
+                positions.push_back(pos);
+            }
+        }
+    }
+    return true;
+}
+
+int RunEvalBench() {
+    std::vector<Position> positions;
+    if (!CollectEvalPositions(positions)) return 1;
+    const int rounds = 20;
+    int64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (const Position& pos : positions) checksum += Evaluate(pos);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t evals = uint64_t(positions.size()) * rounds;
+    printf("Positions: %zu  Evals: %llu  Time: %.3fs  Evals/sec: %.0f  (checksum %lld)\n", positions.size(),
+           (unsigned long long)evals, seconds, evals / (seconds > 0 ? seconds : 1e-9), (long long)checksum);
+    return 0;
+}
+
+// Positions in game order, as a search or an analysis pass would meet them
+int RunPawnBench() {
+    std::vector<Position> positions;
+    if (!CollectEvalPositions(positions)) return 1;
+    const int rounds = 20;
+    uint64_t checksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (const Position& pos : positions) {
+            PawnInfo info;
+            AnalyzePawns(pos, info);
+            checksum += uint64_t(info.score);
+        }
+    }
+    double uncached = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    PawnTable table;
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (const Position& pos : positions) checksum -= uint64_t(table.Probe(pos).score);
+    }
+    double cached = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t queries = uint64_t(positions.size()) * rounds;
+    printf("Queries: %llu  Hits: %llu  Misses: %llu  Hit rate: %.1f%%\n", (unsigned long long)queries,
+           (unsigned long long)table.hits, (unsigned long long)table.misses, 100 * table.HitRate());
+    printf("Uncached: %.0f queries/sec  Cached: %.0f queries/sec  Speedup: %.1fx%s\n",
+           queries / (uncached > 0 ? uncached : 1e-9), queries / (cached > 0 ? cached : 1e-9),
+           uncached / (cached > 0 ? cached : 1e-9), checksum ? "  (cached results differ!)" : "");
+    return checksum ? 1 : 0;
+}
+
+// A pseudo-random game for the NNUE benchmark: the start and every position after it
+struct NnueBenchGame {
+    Position start;
+    std::vector<Position> after;
+    std::vector<Move> moves;
+    std::vector<Piece> captured;
+};
+
+// Replays the same games on every SIMD path: incrementally updated accumulators and
+// from-scratch refreshes, checked against each other and against the scalar code
+int RunNnueBench(const char* path) {
+    NnueNetwork net;
+    if (path ? !net.Load(path) : (net.LoadBuiltin(), false)) {
+        fprintf(stderr, "Cannot load network %s\n", path);
+        return 2;
+    }
+
+    std::vector<NnueBenchGame> games;
+    uint64_t seed = 1;
+    size_t totalPositions = 0;
+    for (const char* fen : BenchPositions) {
+        for (int n = 0; n < 100; n++) {
+            NnueBenchGame game;
+            ParseFen(fen, game.start);
+            Position pos = game.start;
+            for (int ply = 0; ply < 60; ply++) {
+                MoveList moves;
+                GenerateMoves(pos, moves);
+                if (moves.Size() == 0) break;
+                Move m = moves[int(SplitMix64(seed) % moves.Size())];
+                UndoInfo undo;
+                MakeMove(pos, m, undo);
+                game.after.push_back(pos);
+                game.moves.push_back(m);
+                game.captured.push_back(undo.captured);
+            }
+            totalPositions += game.after.size();
+            games.push_back(std::move(game));
+        }
+    }
+
+    const NnueKernels& scalar = NnueKernelSets[2];
+    printf("Network: %s  Default path: %s  Positions: %zu\n", path ? path : "built-in", net.Kernels().name,
+           totalPositions);
+    printf("%8s %16s %16s\n", "path", "incremental/sec", "refresh/sec");
+    const int rounds = 10;
+    std::vector<NnueAccumulator> stack(61);
+
+    for (const NnueKernels& kernels : NnueKernelSets) {
+        if (!kernels.supported()) {
+            printf("%8s %16s %16s\n", kernels.name, "unsupported", "-");
+            continue;
+        }
+        int64_t checksum = 0;
+
+        // Search-like use: one refresh per game, then an update and an evaluation per move
+        net.SetKernels(kernels);
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < rounds; round++) {
+            for (const NnueBenchGame& game : games) {
+                net.Refresh(game.start, stack[0]);
+                for (size_t i = 0; i < game.moves.size(); i++) {
+                    net.Update(game.after[i], game.moves[i], game.captured[i], stack[i], stack[i + 1]);
+                    checksum += net.Evaluate(stack[i + 1], game.after[i].sideToMove);
+                }
+            }
+        }
+        double incremental = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        for (int round = 0; round < rounds; round++) {
+            for (const NnueBenchGame& game : games) {
+                for (const Position& pos : game.after) checksum -= net.Evaluate(pos);
+            }
+        }
+        double refresh = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // Every incremental accumulator must equal a rebuild, and every evaluation the scalar one
+        for (const NnueBenchGame& game : games) {
+            net.SetKernels(kernels);
+            net.Refresh(game.start, stack[0]);
+            for (size_t i = 0; i < game.moves.size(); i++) {
+                const Position& pos = game.after[i];
+                net.Update(pos, game.moves[i], game.captured[i], stack[i], stack[i + 1]);
+                NnueAccumulator fresh;
+                net.Refresh(pos, fresh);
+                int value = net.Evaluate(stack[i + 1], pos.sideToMove);
+                net.SetKernels(scalar);
+                bool same = memcmp(fresh.values, stack[i + 1].values, sizeof(fresh.values)) == 0 &&
+                            fresh.psqt[White] == stack[i + 1].psqt[White] &&
+                            fresh.psqt[Black] == stack[i + 1].psqt[Black] && net.Evaluate(pos) == value;
+                net.SetKernels(kernels);
+                if (!same) {
+                    fprintf(stderr, "%s: NNUE mismatch after %s\n", kernels.name, WriteFen(pos).c_str());
+                    return 1;
+                }
+            }
+        }
+
+        double evals = double(totalPositions) * rounds;
+        printf("%8s %16.0f %16.0f%s\n", kernels.name, evals / (incremental > 0 ? incremental : 1e-9),
+               evals / (refresh > 0 ? refresh : 1e-9), checksum ? "  (incremental and refresh differ!)" : "");
+        if (checksum) return 1;
+    }
+    return 0;
+}
+
+// Opening moves of every game, weighted the way Polyglot's own book maker does:
+// 2 for a move by the eventual winner, 1 for either side in a drawn game
+int RunMakeBook(const char* pgnPath, const char* outPath) {
+    const size_t bookPlies = 24;
+    PgnReader reader;
+    if (!reader.Open(pgnPath)) {
+        fprintf(stderr, "Cannot open %s\n", pgnPath);
+        return 2;
+    }
+    std::vector<PolyglotEntry> entries;
+    PgnGame game;
+    uint64_t games = 0;
+    while (reader.Next(game)) {
+        if (!game.error.empty()) continue;
+        games++;
+        Position pos = game.game.start;
+        for (size_t ply = 0; ply < game.game.moves.size() && ply < bookPlies; ply++) {
+            Move m = game.game.moves[ply];
+            uint16_t weight = game.result == "1/2-1/2" ? 1
+                            : game.result == (pos.sideToMove == White ? "1-0" : "0-1") ? 2 : 0;
+            if (weight) entries.push_back({PolyglotKey(pos), EncodePolyglotMove(m), weight, 0});
+            UndoInfo undo;
+            MakeMove(pos, m, undo);
+        }
+    }
+    if (!WritePolyglotBook(outPath, entries)) {
+        fprintf(stderr, "Cannot write %s\n", outPath);
+        return 2;
+    }
+    printf("Games: %llu  Book moves: %zu  Written to %s\n", (unsigned long long)games, entries.size(), outPath);
+    return 0;
+}
+
+int RunBookBench(const char* bookPath) {
+    PolyglotBook book;
+    if (!book.Open(bookPath)) {
+        fprintf(stderr, "Cannot open book %s\n", bookPath);
+        return 2;
+    }
+    std::vector<Position> positions;
+    if (!CollectEvalPositions(positions)) return 1;
+    Position start;
+    start.SetStartPosition();
+    positions.push_back(start);
+
+    const int rounds = 20;
+    uint64_t hits = 0;
+    PolyglotEntry entries[16];
+    auto begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (const Position& pos : positions) hits += book.Probe(book.KeyOf(pos), entries, 16) > 0;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    uint64_t probes = uint64_t(positions.size()) * rounds;
+    printf("Entries: %zu  Probes: %llu  Hits: %llu  Time: %.3fs  Probes/sec: %.0f  (%.2f us each)\n",
+           book.Size(), (unsigned long long)probes, (unsigned long long)hits, seconds,
+           probes / (seconds > 0 ? seconds : 1e-9), seconds * 1e6 / (probes ? probes : 1));
+    Move m = book.Pick(start, 0);
+    printf("Start position book move: %s\n", m != NullMove ? MoveToUci(m).c_str() : "none");
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int threads = 1;
+    int maxThreads = int(std::thread::hardware_concurrency());
+    int depth = 7;
+    size_t hashMb = 64;
+    bool scaling = false;
+    const char* netPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--scaling") == 0) scaling = true;
+        else if (strcmp(argv[i], "--pgn") == 0 && hasValue) return RunPgnBench(argv[++i]);
+        else if (strcmp(argv[i], "--eval") == 0) return RunEvalBench();
+        else if (strcmp(argv[i], "--pawns") == 0) return RunPawnBench();
+        else if (strcmp(argv[i], "--nnue") == 0) return RunNnueBench(hasValue ? argv[i + 1] : nullptr);
+        else if (strcmp(argv[i], "--write-net") == 0 && hasValue) {
+            NnueNetwork net;
+            net.LoadBuiltin();
+            return net.Save(argv[i + 1]) ? 0 : 2;
+        }
+        else if (strcmp(argv[i], "--book") == 0 && hasValue) return RunBookBench(argv[i + 1]);
+        else if (strcmp(argv[i], "--make-book") == 0 && i + 2 < argc) return RunMakeBook(argv[i + 1], argv[i + 2]);
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--max-threads") == 0 && hasValue) maxThreads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--depth") == 0 && hasValue) depth = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--hash") == 0 && hasValue) hashMb = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--net") == 0 && hasValue) netPath = argv[++i];
+        else {
+            fprintf(stderr, "Usage: %s [--threads N | --scaling [--max-threads N]] [--depth D] [--hash MB] [--net FILE] | --pgn FILE | --eval | --pawns\n"
+                    "       %s --nnue [FILE] | --write-net FILE | --book BOOK | --make-book PGN OUT\n",
+                    argv[0], argv[0]);
+            return 2;
+        }
+    }
+    if (maxThreads < 1) maxThreads = 1;
+
+    // Search with an NNUE network instead of the classical evaluation
+    NnueNetwork network;
+    const NnueNetwork* net = nullptr;
+    if (netPath) {
+        if (strcmp(netPath, "builtin") == 0) network.LoadBuiltin();
+        else if (!network.Load(netPath)) {
+            fprintf(stderr, "Cannot load network %s\n", netPath);
+            return 2;
+        }
+        net = &network;
+    }
+
+    if (!scaling) {
+        BenchTotals t = RunBench(threads, depth, hashMb, true, net);
+        printf("\nThreads: %d  Depth: %d  Nodes: %llu  Time: %.3fs  NPS: %.0f\n", threads, depth,
+               (unsigned long long)t.nodes, t.seconds, t.nodes / (t.seconds > 0 ? t.seconds : 1e-9));
+        uint64_t probes = t.pawnHits + t.pawnMisses;
+        if (probes) {
+            printf("Pawn hash: %llu probes  %.1f%% hits\n", (unsigned long long)probes, 100.0 * t.pawnHits / probes);
+        }
+        return 0;
+    }
+
+    printf("%8s %14s %12s %10s %14s\n", "threads", "nodes/sec", "speedup", "time", "time-to-depth");
+    BenchTotals base;
+    for (int n = 1; n <= maxThreads; n *= 2) {
+        BenchTotals t = RunBench(n, depth, hashMb, false, net);
+        if (n == 1) base = t;
+        double nps = t.nodes / (t.seconds > 0 ? t.seconds : 1e-9);
+        double baseNps = base.nodes / (base.seconds > 0 ? base.seconds : 1e-9);
+        printf("%8d %14.0f %11.2fx %9.3fs %13.2fx\n", n, nps, nps / baseNps, t.seconds,
+               base.seconds / (t.seconds > 0 ? t.seconds : 1e-9));
+    }
+    return 0;
+}
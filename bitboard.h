@@ -0,0 +1,237 @@
+#pragma once
+#include <cstdint>
+#include <immintrin.h>
+#include "piece.h"
+
+// One bit per square, a1 = bit 0, h8 = bit 63
+typedef uint64_t Bitboard;
+
+enum Square : int {
+    A1, B1, C1, D1, E1, F1, G1, H1,
+    A2, B2, C2, D2, E2, F2, G2, H2,
+    A3, B3, C3, D3, E3, F3, G3, H3,
+    A4, B4, C4, D4, E4, F4, G4, H4,
+    A5, B5, C5, D5, E5, F5, G5, H5,
+    A6, B6, C6, D6, E6, F6, G6, H6,
+    A7, B7, C7, D7, E7, F7, G7, H7,
+    A8, B8, C8, D8, E8, F8, G8, H8,
+    NoSquare = 64
+};
+
+const Bitboard FileA = 0x0101010101010101ULL;
+const Bitboard FileH = FileA << 7;
+const Bitboard Rank1 = 0xFFULL;
+const Bitboard Rank8 = Rank1 << 56;
+
+inline int MakeSquare(int file, int rank) { return rank * 8 + file; }
+inline int FileOf(int sq) { return sq & 7; }
+inline int RankOf(int sq) { return sq >> 3; }
+inline Bitboard SquareBB(int sq) { return 1ULL << sq; }
+
+// The GUI draws rank 8 at the top: row 0 is rank 8, col 0 is file a
+inline int SquareAt(int row, int col) { return MakeSquare(col, 7 - row); }
+inline int RowOf(int sq) { return 7 - RankOf(sq); }
+inline int ColOf(int sq) { return FileOf(sq); }
+
+inline int PopCount(Bitboard b) { return __builtin_popcountll(b); }
+inline int Lsb(Bitboard b) { return __builtin_ctzll(b); }
+inline int PopLsb(Bitboard& b) {
+    int sq = Lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+// Shift every bit one step without wrapping around the board edge
+inline Bitboard ShiftNorth(Bitboard b) { return b << 8; }
+inline Bitboard ShiftSouth(Bitboard b) { return b >> 8; }
+inline Bitboard ShiftEast(Bitboard b) { return (b & ~FileH) << 1; }
+inline Bitboard ShiftWest(Bitboard b) { return (b & ~FileA) >> 1; }
+
+// Leaper attack tables, generated at compile time
+struct LeaperTables {
+    Bitboard pawn[2][64];
+    Bitboard knight[64];
+    Bitboard king[64];
+};
+
+constexpr LeaperTables MakeLeaperTables() {
+    LeaperTables t = {};
+    const int knightSteps[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+    const int kingSteps[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+    for (int sq = 0; sq < 64; sq++) {
+        int file = sq & 7, rank = sq >> 3;
+        for (int i = 0; i < 8; i++) {
+            int f = file + knightSteps[i][0], r = rank + knightSteps[i][1];
+            if (f >= 0 && f < 8 && r >= 0 && r < 8) t.knight[sq] |= 1ULL << (r * 8 + f);
+            f = file + kingSteps[i][0];
+            r = rank + kingSteps[i][1];
+            if (f >= 0 && f < 8 && r >= 0 && r < 8) t.king[sq] |= 1ULL << (r * 8 + f);
+        }
+        for (int df = -1; df <= 1; df += 2) {
+            int f = file + df;
+            if (f < 0 || f > 7) continue;
+            if (rank < 7) t.pawn[White][sq] |= 1ULL << ((rank + 1) * 8 + f);
+            if (rank > 0) t.pawn[Black][sq] |= 1ULL << ((rank - 1) * 8 + f);
+        }
+    }
+    return t;
+}
+
+inline constexpr LeaperTables Leapers = MakeLeaperTables();
+
+inline Bitboard PawnAttacks(Side side, int sq) { return Leapers.pawn[side][sq]; }
+inline Bitboard KnightAttacks(int sq) { return Leapers.knight[sq]; }
+inline Bitboard KingAttacks(int sq) { return Leapers.king[sq]; }
+
+// Walk one ray from sq until the edge or the first occupied square (included)
+inline Bitboard RayAttacks(int sq, int fileStep, int rankStep, Bitboard occupied) {
+    Bitboard attacks = 0;
+    int file = FileOf(sq) + fileStep;
+    int rank = RankOf(sq) + rankStep;
+    while (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+        Bitboard b = SquareBB(MakeSquare(file, rank));
+        attacks |= b;
+        if (occupied & b) break; // Path blocked
+        file += fileStep;
+        rank += rankStep;
+    }
+    return attacks;
+}
+
+// Reference slider attacks by walking rays; only used to fill the lookup tables
+inline Bitboard SlidingAttacksSlow(bool rook, int sq, Bitboard occupied) {
+    if (rook) {
+        return RayAttacks(sq, 1, 0, occupied) | RayAttacks(sq, -1, 0, occupied) |
+               RayAttacks(sq, 0, 1, occupied) | RayAttacks(sq, 0, -1, occupied);
+    }
+    return RayAttacks(sq, 1, 1, occupied) | RayAttacks(sq, -1, 1, occupied) |
+           RayAttacks(sq, 1, -1, occupied) | RayAttacks(sq, -1, -1, occupied);
+}
+
+// Slider lookup for one square: relevant-occupancy mask plus its slice of the table
+struct Magic {
+    Bitboard mask;
+    Bitboard magic;
+    Bitboard* attacks;
+    int shift;
+};
+
+inline Magic RookMagics[64];
+inline Magic BishopMagics[64];
+inline Bitboard RookTable[0x19000];  // Sum over squares of 2^(rook mask bits)
+inline Bitboard BishopTable[0x1480];
+
+// Builds that target BMI2 (-mbmi2, -march=native) index with PEXT, everything
+// else with the magic multiply. A runtime-dispatched PEXT cannot be inlined into
+// generic code, and the extra call costs more than the multiply it replaces.
+inline unsigned MagicIndex(const Magic& m, Bitboard occupied) {
+#if defined(__BMI2__)
+    return unsigned(_pext_u64(occupied, m.mask));
+#else
+    return unsigned(((occupied & m.mask) * m.magic) >> m.shift);
+#endif
+}
+
+// Multipliers found offline with a sparse xorshift64* search; each maps every
+// relevant occupancy of its square to a table slot without destructive collisions.
+const Bitboard RookMagicNumbers[64] = {
+    0x0A80004000801220ULL, 0x8040004010002008ULL, 0x2080200010008008ULL, 0x1100100008210004ULL,
+    0xC200209084020008ULL, 0x2100010004000208ULL, 0x0400081000822421ULL, 0x0200010422048844ULL,
+    0x0800800080400024ULL, 0x0001402000401000ULL, 0x3000801000802001ULL, 0x4400800800100083ULL,
+    0x0904802402480080ULL, 0x4040800400020080ULL, 0x0018808042000100ULL, 0x4040800080004100ULL,
+    0x0040048001458024ULL, 0x00A0004000205000ULL, 0x3100808010002000ULL, 0x4825010010000820ULL,
+    0x5004808008000401ULL, 0x2024818004000A00ULL, 0x0005808002000100ULL, 0x2100060004806104ULL,
+    0x0080400880008421ULL, 0x4062220600410280ULL, 0x010A004A00108022ULL, 0x0000100080080080ULL,
+    0x0021000500080010ULL, 0x0044000202001008ULL, 0x0000100400080102ULL, 0xC020128200040545ULL,
+    0x0080002000400040ULL, 0x0000804000802004ULL, 0x0000120022004080ULL, 0x010A386103001001ULL,
+    0x9010080080800400ULL, 0x8440020080800400ULL, 0x0004228824001001ULL, 0x000000490A000084ULL,
+    0x0080002000504000ULL, 0x200020005000C000ULL, 0x0012088020420010ULL, 0x0010010080080800ULL,
+    0x0085001008010004ULL, 0x0002000204008080ULL, 0x0040413002040008ULL, 0x0000304081020004ULL,
+    0x0080204000800080ULL, 0x3008804000290100ULL, 0x1010100080200080ULL, 0x2008100208028080ULL,
+    0x5000850800910100ULL, 0x8402019004680200ULL, 0x0120911028020400ULL, 0x0000008044010200ULL,
+    0x0020850200244012ULL, 0x0020850200244012ULL, 0x0000102001040841ULL, 0x140900040A100021ULL,
+    0x000200282410A102ULL, 0x000200282410A102ULL, 0x000200282410A102ULL, 0x4048240043802106ULL,
+};
+
+const Bitboard BishopMagicNumbers[64] = {
+    0x40106000A1160020ULL, 0x0020010250810120ULL, 0x2010010220280081ULL, 0x002806004050C040ULL,
+    0x0002021018000000ULL, 0x2001112010000400ULL, 0x0881010120218080ULL, 0x1030820110010500ULL,
+    0x0000120222042400ULL, 0x2000020404040044ULL, 0x8000480094208000ULL, 0x0003422A02000001ULL,
+    0x000A220210100040ULL, 0x8004820202226000ULL, 0x0018234854100800ULL, 0x0100004042101040ULL,
+    0x0004001004082820ULL, 0x0010000810010048ULL, 0x1014004208081300ULL, 0x2080818802044202ULL,
+    0x0040880C00A00100ULL, 0x0080400200522010ULL, 0x0001000188180B04ULL, 0x0080249202020204ULL,
+    0x1004400004100410ULL, 0x00013100A0022206ULL, 0x2148500001040080ULL, 0x4241080011004300ULL,
+    0x4020848004002000ULL, 0x10101380D1004100ULL, 0x0008004422020284ULL, 0x01010A1041008080ULL,
+    0x0808080400082121ULL, 0x0808080400082121ULL, 0x0091128200100C00ULL, 0x0202200802010104ULL,
+    0x8C0A020200440085ULL, 0x01A0008080B10040ULL, 0x0889520080122800ULL, 0x100902022202010AULL,
+    0x04081A0816002000ULL, 0x0000681208005000ULL, 0x8170840041008802ULL, 0x0A00004200810805ULL,
+    0x0830404408210100ULL, 0x2602208106006102ULL, 0x1048300680802628ULL, 0x2602208106006102ULL,
+    0x0602010120110040ULL, 0x0941010801043000ULL, 0x000040440A210428ULL, 0x0008240020880021ULL,
+    0x0400002012048200ULL, 0x00AC102001210220ULL, 0x0220021002009900ULL, 0x84440C080A013080ULL,
+    0x0001008044200440ULL, 0x0004C04410841000ULL, 0x2000500104011130ULL, 0x1A0C010011C20229ULL,
+    0x0044800112202200ULL, 0x0434804908100424ULL, 0x0300404822C08200ULL, 0x48081010008A2A80ULL,
+};
+
+inline void InitMagics(bool rook, Magic* magics, Bitboard* table) {
+    Bitboard* next = table;
+    for (int sq = 0; sq < 64; sq++) {
+        Bitboard edges = ((Rank1 | Rank8) & ~(Rank1 << (8 * RankOf(sq)))) |
+                         ((FileA | FileH) & ~(FileA << FileOf(sq)));
+        Magic& m = magics[sq];
+        m.mask = SlidingAttacksSlow(rook, sq, 0) & ~edges;
+        m.magic = rook ? RookMagicNumbers[sq] : BishopMagicNumbers[sq];
+        m.shift = 64 - PopCount(m.mask);
+        m.attacks = next;
+        next += 1 << PopCount(m.mask);
+
+        // Enumerate every subset of the mask (Carry-Rippler) and store its attack set
+        Bitboard b = 0;
+        do {
+            m.attacks[MagicIndex(m, b)] = SlidingAttacksSlow(rook, sq, b);
+            b = (b - m.mask) & m.mask;
+        } while (b);
+    }
+}
+
+inline Bitboard BishopAttacks(int sq, Bitboard occupied) {
+    const Magic& m = BishopMagics[sq];
+    return m.attacks[MagicIndex(m, occupied)];
+}
+
+inline Bitboard RookAttacks(int sq, Bitboard occupied) {
+    const Magic& m = RookMagics[sq];
+    return m.attacks[MagicIndex(m, occupied)];
+}
+
+inline Bitboard QueenAttacks(int sq, Bitboard occupied) {
+    return BishopAttacks(sq, occupied) | RookAttacks(sq, occupied);
+}
+
+// Squares strictly between two aligned squares, and the whole line through them
+inline Bitboard BetweenTable[64][64];
+inline Bitboard LineTable[64][64];
+
+inline Bitboard Between(int a, int b) { return BetweenTable[a][b]; }
+inline Bitboard Line(int a, int b) { return LineTable[a][b]; }
+
+// Fills the slider and line tables once at process start (a few milliseconds)
+inline bool InitSliderAttacks() {
+    InitMagics(true, RookMagics, RookTable);
+    InitMagics(false, BishopMagics, BishopTable);
+
+    for (int a = 0; a < 64; a++) {
+        for (int b = 0; b < 64; b++) {
+            BetweenTable[a][b] = LineTable[a][b] = 0;
+            if (a == b) continue;
+            for (int rook = 0; rook < 2; rook++) {
+                Bitboard (*attacks)(int, Bitboard) = rook ? RookAttacks : BishopAttacks;
+                if (!(attacks(a, 0) & SquareBB(b))) continue;
+                LineTable[a][b] = (attacks(a, 0) & attacks(b, 0)) | SquareBB(a) | SquareBB(b);
+                BetweenTable[a][b] = attacks(a, SquareBB(b)) & attacks(b, SquareBB(a));
+            }
+        }
+    }
+    return true;
+}
+
+inline const bool SliderAttacksReady = InitSliderAttacks();
@@ -1,642 +1,462 @@
-#include "piece.h"
-#include <vector>
-#include <algorithm>
-
-// Helper function to find piece at position
-Piece* FindPieceAt(int row, int col, const std::vector<Piece*>& pieces) {
-    for (auto* p : pieces) {
-        if (p->GetRow() == row && p->GetCol() == col) {
-            return p;
-        }
-    }
-    return nullptr;
+// Build: g++ -O2 -std=c++17 chess.cpp -o chess -lraylib -pthread
+#include <raylib.h>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include "atlas.h"
+#include "fen.h"
+#include "ui.h"
+
+// Draw a piece from the atlas centred on its square
+void DrawPiece(Texture2D atlas, Piece p, int sq, int squareSize, float scale = 0.5f) {
+    float w = AtlasCellWidth * scale, h = AtlasCellHeight * scale;
+    Rectangle dest = {ColOf(sq) * squareSize + (squareSize - w) / 2, RowOf(sq) * squareSize + (squareSize - h) / 2, w, h};
+    DrawTexturePro(atlas, AtlasSource(p), dest, {0, 0}, 0.0f, WHITE);
 }
 
-// Find the king of a given color
-Piece* FindKing(bool isWhite, const std::vector<Piece*>& pieces) {
-    for (auto* p : pieces) {
-        if (p->GetName() == "King" && p->IsWhite() == isWhite) {
-            return p;
+// Render the static part of the frame (squares, check and pawn highlights, pieces)
+// into `layer`. Called only when the position or the hint toggle changes; every
+// other frame just blits the texture.
+void DrawBoardLayer(RenderTexture2D layer, const Position& pos, Texture2D atlas,
+                    int squareSize, const PawnInfo* pawnHints) {
+    PROFILE_SCOPE(ProfileDrawBoardLayer);
+    BeginTextureMode(layer);
+    ClearBackground(RAYWHITE);
+
+    for (int row = 0; row < 8; row++) {
+        for (int col = 0; col < 8; col++) {
+            Color c = ((row + col) % 2 == 0) ? LightSquareColor : DarkSquareColor;
+            DrawRectangle(col * squareSize, row * squareSize, squareSize, squareSize, c);
         }
     }
-    return nullptr;
-}
 
-// Check if a square is under attack by opponent
-bool IsSquareUnderAttack(int row, int col, bool byWhite, const std::vector<Piece*>& pieces) {
-    for (auto* p : pieces) {
-        if (p->GetRow() == row && p->GetCol() == col) continue; // Skip the piece on this square
-        
-        if (p->IsWhite() == byWhite) {
-            // Special case for pawns - they attack diagonally
-            if (p->GetName() == "Pawn") {
-                int dir = byWhite ? -1 : 1;
-                int rowDiff = row - p->GetRow();
-                int colDiff = abs(col - p->GetCol());
-                if (rowDiff == dir && colDiff == 1) {
-                    return true;
-                }
-            } else {
-                if (p->IsMoveValid(row, col, pieces)) {
-                    return true;
-                }
+    // Highlight king if in check
+    if (pos.checkers) {
+        int king = pos.KingSquare(pos.sideToMove);
+        DrawRectangle(ColOf(king) * squareSize, RowOf(king) * squareSize,
+                      squareSize, squareSize, Color{255, 0, 0, 80});
+    }
+
+    if (pawnHints) {
+        for (Side side : {White, Black}) {
+            for (Bitboard b = pawnHints->passed[side]; b; ) {
+                int sq = PopLsb(b);
+                DrawRectangle(ColOf(sq) * squareSize, RowOf(sq) * squareSize, squareSize, squareSize,
+                              Color{255, 215, 0, 90});
+            }
+            Bitboard weak = pawnHints->isolated[side] | pawnHints->backward[side] | pawnHints->doubled[side];
+            for (Bitboard b = weak; b; ) {
+                int sq = PopLsb(b);
+                DrawRectangle(ColOf(sq) * squareSize, RowOf(sq) * squareSize, squareSize, squareSize,
+                              Color{255, 0, 0, 60});
             }
         }
     }
-    return false;
+
+    for (int p = 0; p < PieceCount; p++) {
+        for (Bitboard b = pos.pieces[p]; b; ) DrawPiece(atlas, Piece(p), PopLsb(b), squareSize);
+    }
+    EndTextureMode();
 }
 
-// Check if the king is currently in check
-bool IsInCheck(bool whiteKing, const std::vector<Piece*>& pieces) {
-    Piece* king = FindKing(whiteKing, pieces);
-    if (!king) return false;
-    
-    return IsSquareUnderAttack(king->GetRow(), king->GetCol(), !whiteKing, pieces);
+// Render textures are stored bottom-up; a negative source height flips them back
+void DrawLayer(RenderTexture2D layer) {
+    PROFILE_SCOPE(ProfileDrawLayer);
+    Rectangle source = {0, 0, (float)layer.texture.width, -(float)layer.texture.height};
+    DrawTextureRec(layer.texture, source, {0, 0}, WHITE);
 }
 
-// checking that move and check if it leaves/puts the king in check
-bool WouldBeInCheck(Piece* piece, int newRow, int newCol, bool isWhite, std::vector<Piece*>& pieces) {
-    // Save current state
-    int oldRow = piece->GetRow();
-    int oldCol = piece->GetCol();
-    Piece* capturedPiece = FindPieceAt(newRow, newCol, pieces);
-    
-    // Temporarily remove captured piece
-    if (capturedPiece) {
-        pieces.erase(std::remove(pieces.begin(), pieces.end(), capturedPiece), pieces.end());
+// Promotion choice drawn over the board; the UI state machine handles the keys
+void DrawPromotionOverlay(int choice, int width, int height) {
+    PROFILE_SCOPE(ProfileDrawOverlay);
+    DrawRectangle(0, 0, width, height, Color{0, 0, 0, 150});
+    DrawText("Choose promotion piece:", 250, 250, 24, WHITE);
+    const char* options[] = {"1 - Queen", "2 - Rook", "3 - Bishop", "4 - Knight"};
+    for (int i = 0; i < 4; i++) {
+        DrawText(options[i], 300, 300 + i * 40, 20, i == choice ? YELLOW : WHITE);
     }
-    
-    // Make the move temporarily
-    piece->SetPosition(newRow, newCol);
-    
-    // Check if king is in check
-    bool inCheck = IsInCheck(isWhite, pieces);
-    
-    // Restore state
-    piece->SetPosition(oldRow, oldCol);
-    if (capturedPiece) {
-        pieces.push_back(capturedPiece);
-    }
-    
-    return inCheck;
 }
 
-// NEW: Check if a move resolves check (only used when king is in check)
-bool DoesResolveCheck(Piece* piece, int newRow, int newCol, bool isWhite, std::vector<Piece*>& pieces) {
-    // This is the same as WouldBeInCheck but returns the opposite
-    // If the move results in NOT being in check, it resolves the check
-    return !WouldBeInCheck(piece, newRow, newCol, isWhite, pieces);
+void DrawGameOverOverlay(const char* message, int width, int height) {
+    PROFILE_SCOPE(ProfileDrawOverlay);
+    DrawRectangle(0, 0, width, height, Color{0, 0, 0, 180});
+    int textWidth = MeasureText(message, 36);
+    DrawText(message, (width - textWidth) / 2, 300, 36, GOLD);
+    const char* restart = "Press ENTER to restart or ESC to quit";
+    int restartWidth = MeasureText(restart, 20);
+    DrawText(restart, (width - restartWidth) / 2, 400, 20, WHITE);
 }
 
-// Check if a player has any legal moves
-bool HasLegalMoves(bool isWhite, std::vector<Piece*>& pieces) {
-    for (auto* p : pieces) {
-        if (p->IsWhite() != isWhite) continue;
-        
-        // Try all possible squares
-        for (int r = 0; r < 8; r++) {
-            for (int c = 0; c < 8; c++) {
-                // Skip if same position
-                if (r == p->GetRow() && c == p->GetCol()) continue;
-                
-                // Check if move is valid
-                if (!p->IsMoveValid(r, c, pieces)) continue;
-                
-                // Check if target square has friendly piece
-                Piece* target = FindPieceAt(r, c, pieces);
-                if (target && target->IsWhite() == isWhite) continue;
-                
-                // Check if move would leave king in check
-                if (!WouldBeInCheck(p, r, c, isWhite, pieces)) {
-                    return true; // Found a legal move
-                }
-            }
-        }
+// Frame-time percentiles and per-frame calls of the instrumented functions (P)
+void DrawProfileOverlay(const FrameProfiler& profiler, int width) {
+    PROFILE_SCOPE(ProfileDrawOverlay);
+    const int lineHeight = 18, boxWidth = 330;
+    int x = width - boxWidth - 10, y = 10;
+    DrawRectangle(x, y, boxWidth, lineHeight * (ProfileCounterCount + 3) + 10, Color{0, 0, 0, 190});
+    x += 8;
+    y += 6;
+    DrawText(TextFormat("Frame ms  p50 %.2f  p95 %.2f  p99 %.2f", profiler.FramePercentile(50),
+                        profiler.FramePercentile(95), profiler.FramePercentile(99)), x, y, 14, WHITE);
+    y += lineHeight;
+    if (!ProfileEnabled) {
+        DrawText("Counters compiled out: build with -DCHESS_PROFILE", x, y, 14, GRAY);
+        return;
+    }
+    // The default font is proportional, so columns get their own x
+    DrawText("Per frame", x, y, 14, GRAY);
+    DrawText("calls", x + 180, y, 14, GRAY);
+    DrawText("us", x + 260, y, 14, GRAY);
+    y += lineHeight;
+    for (int c = 0; c < ProfileCounterCount; c++) {
+        double calls, us;
+        profiler.Recent(ProfileCounter(c), calls, us);
+        DrawText(ProfileCounterNames[c], x, y, 14, WHITE);
+        DrawText(TextFormat("%.1f", calls), x + 180, y, 14, WHITE);
+        DrawText(TextFormat("%.1f", us), x + 260, y, 14, WHITE);
+        y += lineHeight;
     }
-    return false;
-}
-
-// Check for stalemate or checkmate
-bool IsCheckmate(bool isWhite, std::vector<Piece*>& pieces) {
-    return IsInCheck(isWhite, pieces) && !HasLegalMoves(isWhite, pieces);
 }
 
-bool IsStalemate(bool isWhite, std::vector<Piece*>& pieces) {
-    return !IsInCheck(isWhite, pieces) && !HasLegalMoves(isWhite, pieces);
+const int WdlBarWidth = 64;
+
+// Playout estimate beside the board: white's wins from the bottom, black's from the
+// top, draws in between, with the percentages and the playout rate
+void DrawWdlBar(const PlayoutStats& stats, int x, int height) {
+    PROFILE_SCOPE(ProfileDrawHud);
+    DrawRectangle(x, 0, WdlBarWidth, height, DARKGRAY);
+    uint64_t total = stats.Total();
+    if (total == 0) return;
+    int white = int(height * stats.whiteWins / total);
+    int black = int(height * stats.blackWins / total);
+    DrawRectangle(x, 0, WdlBarWidth, black, BLACK);
+    DrawRectangle(x, height - white, WdlBarWidth, white, RAYWHITE);
+    DrawRectangle(x, black, WdlBarWidth, height - white - black, GRAY);
+    DrawText(TextFormat("B %.0f%%", 100.0 * stats.blackWins / total), x + 6, 8, 14, WHITE);
+    DrawText(TextFormat("D %.0f%%", 100.0 * stats.draws / total), x + 6, height / 2 - 7, 14, WHITE);
+    DrawText(TextFormat("W %.0f%%", 100.0 * stats.whiteWins / total), x + 6, height - 22, 14, BLACK);
+    DrawText(TextFormat("%.1fk/s", stats.playoutsPerSec / 1000), x + 6, height / 2 + 12, 10, LIGHTGRAY);
+    DrawText(TextFormat("%llu", (unsigned long long)total), x + 6, height / 2 + 26, 10, LIGHTGRAY);
 }
 
-// Check for insufficient material draw
-bool IsInsufficientMaterial(const std::vector<Piece*>& pieces) {
-    int knights = 0, bishops = 0, whiteBishopLight = -1, blackBishopLight = -1;
-    
-    for (auto* p : pieces) {
-        std::string name = p->GetName();
-        if (name == "Pawn" || name == "Rook" || name == "Queen") {
-            return false; // These pieces can deliver checkmate
-        }
-        if (name == "Knight") knights++;
-        if (name == "Bishop") {
-            int lightSquare = (p->GetRow() + p->GetCol()) % 2;
-            if (p->IsWhite()) {
-                whiteBishopLight = lightSquare;
-            } else {
-                blackBishopLight = lightSquare;
-            }
-            bishops++;
+// Selection, move dots and the text around the board: everything drawn every frame
+// on top of the cached board layer
+void DrawHud(const ChessUi& ui, int width, int height, int squareSize) {
+    PROFILE_SCOPE(ProfileDrawHud);
+    const Position& pos = ui.Pos();
+
+    // Draw highlight if selected
+    if (ui.Selected() != NoSquare) {
+        int selectedRow = RowOf(ui.Selected()), selectedCol = ColOf(ui.Selected());
+        DrawRectangle(selectedCol * squareSize,
+                     selectedRow * squareSize,
+                     squareSize, squareSize, Color{255, 215, 0, 60});
+        Rectangle rect = {
+            (float)(selectedCol * squareSize),
+            (float)(selectedRow * squareSize),
+            (float)squareSize, (float)squareSize};
+        DrawRectangleLinesEx(rect, 3, GOLD);
+        
+        // Show valid moves for selected piece
+        for (Move m : ui.SelectedMoves()) {
+            int to = MoveTo(m);
+
+            // Draw small circle for valid moves
+            int centerX = ColOf(to) * squareSize + squareSize / 2;
+            int centerY = RowOf(to) * squareSize + squareSize / 2;
+            Color dotColor = IsCapture(m) ? Color{255, 0, 0, 100} : Color{0, 255, 0, 100};
+            DrawCircle(centerX, centerY, 10, dotColor);
         }
     }
+
+    // Display whose turn
+    bool whiteTurn = pos.sideToMove == White;
+    const char* turnText = whiteTurn ? "White's Turn" : "Black's Turn";
+    DrawText(turnText, 10, 10, 20, whiteTurn ? WHITE : BLACK);
     
-    // King vs King
-    if (knights == 0 && bishops == 0) return true;
-    
-    // King + minor piece vs King
-    if (knights + bishops == 1) return true;
-    
-    // King + Knight vs King + Knight
-    if (knights == 2 && bishops == 0) return true;
+    if (ui.EngineTurn()) {
+        DrawText("Engine thinking...", 10, height - 26, 16, GRAY);
+    }
+    if (ui.SaveMessage()) {
+        DrawText(ui.SaveMessage(), width - MeasureText(ui.SaveMessage(), 16) - 10, height - 26, 16, GRAY);
+    }
+
+    // Display move counter
+    DrawText(TextFormat("Move: %d", ui.MoveCounter()), 10, 35, 16, GRAY);
     
-    // King + Bishop vs King + Bishop (same color squares)
-    if (bishops == 2 && knights == 0 && 
-        whiteBishopLight != -1 && blackBishopLight != -1 &&
-        whiteBishopLight == blackBishopLight) {
-        return true;
+    // Display check status
+    if (pos.checkers) {
+        const char* checkText = "CHECK!";
+        int textWidth = MeasureText(checkText, 24);
+        DrawText(checkText, (width - textWidth) / 2, 10, 24, RED);
     }
     
-    return false;
+    if (ui.HasNnueScore()) {
+        DrawText(TextFormat("NNUE: %+.2f", ui.NnueScore() / 100.0), 10, 85, 16, GRAY);
+    }
+    if (!ui.TablebaseVerdict().empty()) {
+        DrawText(ui.TablebaseVerdict().c_str(), 10, 110, 16, GOLD);
+    }
+
+    // Display half-move clock
+    DrawText(TextFormat("50-move rule: %d/50", pos.halfMoveClock / 2), 10, 60, 16, GRAY);
 }
 
-// Pawn promotion dialog
-void ShowPromotionDialog(Piece*& pawn, std::vector<Piece*>& pieces, 
-                        Texture2D queen, Texture2D rook, Texture2D bishop, Texture2D knight,
-                        int squareSize) {
-    bool choosing = true;
-    int choice = 0; // 0=Queen, 1=Rook, 2=Bishop, 3=Knight
-    
-    while (choosing && !WindowShouldClose()) {
-        BeginDrawing();
-        ClearBackground(RAYWHITE);
-        
-        // Draw semi-transparent overlay
-        DrawRectangle(0, 0, 800, 800, Color{0, 0, 0, 150});
-        
-        // Draw promotion options
-        const char* title = "Choose promotion piece:";
-        DrawText(title, 250, 250, 24, WHITE);
-        
-        const char* options[] = {"1 - Queen", "2 - Rook", "3 - Bishop", "4 - Knight"};
-        for (int i = 0; i < 4; i++) {
-            Color color = (i == choice) ? YELLOW : WHITE;
-            DrawText(options[i], 300, 300 + i * 40, 20, color);
-        }
-        
-        EndDrawing();
-        
-        // Handle input
-        if (IsKeyPressed(KEY_ONE)) choice = 0;
-        if (IsKeyPressed(KEY_TWO)) choice = 1;
-        if (IsKeyPressed(KEY_THREE)) choice = 2;
-        if (IsKeyPressed(KEY_FOUR)) choice = 3;
-        if (IsKeyPressed(KEY_UP)) choice = (choice - 1 + 4) % 4;
-        if (IsKeyPressed(KEY_DOWN)) choice = (choice + 1) % 4;
-        
-        if (IsKeyPressed(KEY_ENTER) || IsKeyPressed(KEY_SPACE)) {
-            choosing = false;
-        }
+// This frame's mouse click and key press as UI input
+UiInput ReadInput(int squareSize) {
+    UiInput input;
+    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+        Vector2 mousePos = GetMousePosition();
+        int col = mousePos.x / squareSize;
+        int row = mousePos.y / squareSize;
+        if (row >= 0 && row < 8 && col >= 0 && col < 8) input.click = SquareAt(row, col);
     }
-    
-    // Replace pawn with chosen piece
-    int row = pawn->GetRow();
-    int col = pawn->GetCol();
-    bool isWhite = pawn->IsWhite();
-    
-    // Find and remove pawn
-    for (int i = 0; i < pieces.size(); i++) {
-        if (pieces[i] == pawn) {
-            delete pieces[i];
-            pieces.erase(pieces.begin() + i);
+    static const struct { int raylibKey; UiKey key; } keys[] = {
+        {KEY_ENTER, UiKeyEnter}, {KEY_SPACE, UiKeyEnter}, {KEY_ESCAPE, UiKeyEscape},
+        {KEY_UP, UiKeyUp}, {KEY_DOWN, UiKeyDown},
+        {KEY_ONE, UiKeyQueen}, {KEY_TWO, UiKeyRook}, {KEY_THREE, UiKeyBishop}, {KEY_FOUR, UiKeyKnight},
+        {KEY_S, UiKeySave}, {KEY_H, UiKeyHints}, {KEY_P, UiKeyProfile},
+    };
+    for (const auto& k : keys) {
+        if (IsKeyPressed(k.raylibKey)) {
+            input.key = k.key;
             break;
         }
     }
-    
-    // Add new piece
-    Piece* newPiece = nullptr;
-    switch(choice) {
-        case 0: newPiece = new Queen(queen, row, col, isWhite); break;
-        case 1: newPiece = new Rook(rook, row, col, isWhite); break;
-        case 2: newPiece = new Bishop(bishop, row, col, isWhite); break;
-        case 3: newPiece = new Knight(knight, row, col, isWhite); break;
+    return input;
+}
+
+bool LoadUiScript(const char* path, std::vector<UiScriptStep>& script) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Cannot open script %s\n", path);
+        return false;
+    }
+    char line[256];
+    int lineNumber = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        lineNumber++;
+        UiScriptStep step;
+        bool empty;
+        ok = ParseUiScriptLine(line, step, empty);
+        if (!ok) fprintf(stderr, "%s:%d: bad script line: %s", path, lineNumber, line);
+        else if (!empty) script.push_back(step);
     }
-    pieces.push_back(newPiece);
+    fclose(file);
+    return ok;
 }
 
-// Game over screen
-void ShowGameOver(const char* message, int squareSize) {
-    while (!WindowShouldClose()) {
-        BeginDrawing();
-        ClearBackground(RAYWHITE);
-        
-        // Draw semi-transparent overlay
-        DrawRectangle(0, 0, 800, 800, Color{0, 0, 0, 180});
-        
-        // Draw game over message
-        int textWidth = MeasureText(message, 36);
-        DrawText(message, (800 - textWidth) / 2, 300, 36, GOLD);
-        
-        const char* restart = "Press ENTER to restart or ESC to quit";
-        int restartWidth = MeasureText(restart, 20);
-        DrawText(restart, (800 - restartWidth) / 2, 400, 20, WHITE);
-        
-        EndDrawing();
-        
-        if (IsKeyPressed(KEY_ENTER)) {
-            return; // Restart game
-        }
-        if (IsKeyPressed(KEY_ESCAPE)) {
-            exit(0); // Quit
-        }
+// One frame of scripted input; a wait step idles until the engine has moved
+UiInput NextScriptInput(const ChessUi& ui, const std::vector<UiScriptStep>& script, size_t& step) {
+    if (script[step].waitForEngine) {
+        if (!ui.EngineTurn()) step++;
+        return UiInput();
     }
+    return script[step++].input;
 }
 
-int main() {
+int main(int argc, char** argv) {
+    // --engine white|black|both hands that colour to the computer, --movetime sets its
+    // budget, --hash the size of its transposition table in MB and --threads its threads.
+    // --fen starts from a position and --load resumes the first game of a PGN file.
+    // --nnue FILE|builtin evaluates with a network, for the engine and the on-screen score.
+    // S saves the game to --save (default game.pgn); H toggles pawn-structure hints.
+    // --book FILE plays the engine's opening moves from a Polyglot book.
+    // --tb DIR loads endgame tables (see tbgen.cpp) for the engine and the on-screen verdict.
+    // --script FILE replays scripted input (see ui.h) before handing over to the mouse;
+    // --headless FILE runs a script without opening a window and prints the final position.
+    // P shows frame times and hot-path counters (see profile.h); --profile FILE writes them
+    // per frame on exit, as CSV if FILE ends in .csv and JSON otherwise.
+    // --playouts N runs random playouts on N threads for a win/draw/loss bar beside the board.
+    bool engineWhite = false, engineBlack = false;
+    Game initialGame;
+    Position initialPos;
+    initialPos.SetStartPosition();
+    initialGame.Reset(initialPos);
+    const char* savePath = "game.pgn";
+    const char* netPath = nullptr;
+    const char* scriptPath = nullptr;
+    const char* bookPath = nullptr;
+    const char* tbPath = nullptr;
+    const char* profilePath = nullptr;
+    int playoutThreads = 0;
+    bool headless = false;
+    SearchLimits engineLimits;
+    engineLimits.movetimeMs = 1000;
+    size_t hashMb = 64;
+    int threads = 1;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--engine") == 0) {
+            engineWhite = strcmp(argv[i + 1], "white") == 0 || strcmp(argv[i + 1], "both") == 0;
+            engineBlack = strcmp(argv[i + 1], "black") == 0 || strcmp(argv[i + 1], "both") == 0;
+        } else if (strcmp(argv[i], "--movetime") == 0) {
+            engineLimits.movetimeMs = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--hash") == 0) {
+            hashMb = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            threads = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--fen") == 0) {
+            if (!ParseFen(argv[i + 1], initialPos)) {
+                fprintf(stderr, "Invalid FEN: %s\n", argv[i + 1]);
+                return 1;
+            }
+            initialGame.Reset(initialPos);
+        } else if (strcmp(argv[i], "--load") == 0) {
+            PgnReader reader;
+            PgnGame loaded;
+            if (!reader.Open(argv[i + 1]) || !reader.Next(loaded) || !loaded.error.empty()) {
+                fprintf(stderr, "Cannot load %s: %s\n", argv[i + 1], loaded.error.c_str());
+                return 1;
+            }
+            initialGame = loaded.game;
+        } else if (strcmp(argv[i], "--save") == 0) {
+            savePath = argv[i + 1];
+        } else if (strcmp(argv[i], "--nnue") == 0) {
+            netPath = argv[i + 1];
+        } else if (strcmp(argv[i], "--book") == 0) {
+            bookPath = argv[i + 1];
+        } else if (strcmp(argv[i], "--tb") == 0) {
+            tbPath = argv[i + 1];
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            profilePath = argv[i + 1];
+        } else if (strcmp(argv[i], "--playouts") == 0) {
+            playoutThreads = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--script") == 0 || strcmp(argv[i], "--headless") == 0) {
+            scriptPath = argv[i + 1];
+            headless = strcmp(argv[i], "--headless") == 0;
+        }
+    }
+
     const int width = 800;
     const int height = 800;
     const int squareSize = width / 8;
 
-    InitWindow(width, height, "Two-Player Chess");
-    SetTargetFPS(60);
-
-    
-    Texture2D b_pawn = LoadTexture("./Images/b_pawn_png_128px.png");
-    Texture2D b_rook = LoadTexture("./Images/b_rook_png_128px.png");
-    Texture2D b_knight = LoadTexture("./Images/b_knight_png_128px.png");
-    Texture2D b_bishop = LoadTexture("./Images/b_bishop_png_128px.png");
-    Texture2D b_queen = LoadTexture("./Images/b_queen_png_128px.png");
-    Texture2D b_king = LoadTexture("./Images/b_king_png_128px.png");
-
-    
-    Texture2D w_pawn = LoadTexture("./Images/w_pawn_png_128px.png");
-    Texture2D w_rook = LoadTexture("./Images/w_rook_png_128px.png");
-    Texture2D w_knight = LoadTexture("./Images/w_knight_png_128px.png");
-    Texture2D w_bishop = LoadTexture("./Images/w_bishop_png_128px.png");
-    Texture2D w_queen = LoadTexture("./Images/w_queen_png_128px.png");
-    Texture2D w_king = LoadTexture("./Images/w_king_png_128px.png");
-
-    bool gameRunning = true;
-
-    while (gameRunning) {
-        std::vector<Piece*> pieces;
-
-        // Black pieces (top of board)
-        for (int col = 0; col < 8; col++) {
-            pieces.push_back(new Pawn(b_pawn, 1, col, false));
+    // The engine searches on its own thread; the frame loop only polls it
+    TranspositionTable tt(hashMb);
+    SearchPool engine(tt, threads);
+    NnueNetwork network;
+    if (netPath) {
+        if (strcmp(netPath, "builtin") == 0) {
+            network.LoadBuiltin();
+        } else if (!network.Load(netPath)) {
+            fprintf(stderr, "Cannot load network %s\n", netPath);
+            return 1;
         }
-        pieces.push_back(new Rook(b_rook, 0, 0, false));
-        pieces.push_back(new Knight(b_knight, 0, 1, false));
-        pieces.push_back(new Bishop(b_bishop, 0, 2, false));
-        pieces.push_back(new Queen(b_queen, 0, 3, false));
-        pieces.push_back(new King(b_king, 0, 4, false));
-        pieces.push_back(new Bishop(b_bishop, 0, 5, false));
-        pieces.push_back(new Knight(b_knight, 0, 6, false));
-        pieces.push_back(new Rook(b_rook, 0, 7, false));
-
-        // White pieces (bottom of board)
-        for (int col = 0; col < 8; col++) {
-            pieces.push_back(new Pawn(w_pawn, 6, col, true));
+        engine.SetNetwork(&network);
+    }
+    Tablebase tablebase;
+    if (tbPath) {
+        if (tablebase.Load(tbPath) == 0) {
+            fprintf(stderr, "No tablebase files in %s\n", tbPath);
+            return 1;
         }
-        pieces.push_back(new Rook(w_rook, 7, 0, true));
-        pieces.push_back(new Knight(w_knight, 7, 1, true));
-        pieces.push_back(new Bishop(w_bishop, 7, 2, true));
-        pieces.push_back(new Queen(w_queen, 7, 3, true));
-        pieces.push_back(new King(w_king, 7, 4, true));
-        pieces.push_back(new Bishop(w_bishop, 7, 5, true));
-        pieces.push_back(new Knight(w_knight, 7, 6, true));
-        pieces.push_back(new Rook(w_rook, 7, 7, true));
-
-        Piece* selectedPiece = nullptr;
-        int selectedRow = -1, selectedCol = -1;
-        bool whiteTurn = true;
-        int moveCounter = 0;
-        int halfMoveClock = 0; // For 50-move rule
-        Pawn* lastDoubleStepPawn = nullptr;
-        bool gameOver = false;
-
-        while (!WindowShouldClose() && !gameOver) {
-            // Check for game ending conditions
-            if (IsCheckmate(whiteTurn, pieces)) {
-                const char* winner = whiteTurn ? "Black wins by checkmate!" : "White wins by checkmate!";
-                ShowGameOver(winner, squareSize);
-                break;
-            }
-            
-            if (IsStalemate(whiteTurn, pieces)) {
-                ShowGameOver("Draw by stalemate!", squareSize);
-                break;
-            }
-            
-            if (IsInsufficientMaterial(pieces)) {
-                ShowGameOver("Draw by insufficient material!", squareSize);
-                break;
-            }
-            
-            if (halfMoveClock >= 100) { // 50 moves = 100 half-moves
-                ShowGameOver("Draw by 50-move rule!", squareSize);
-                break;
-            }
-
-            BeginDrawing();
-            ClearBackground(RAYWHITE);
+        engine.SetTablebase(&tablebase);
+    }
 
-            // Draw chessboard
-            for (int row = 0; row < 8; row++) {
-                for (int col = 0; col < 8; col++) {
-                    Color c = ((row + col) % 2 == 0) ? LIGHTGRAY : DARKGREEN;
-                    DrawRectangle(col * squareSize, row * squareSize, squareSize, squareSize, c);
-                }
-            }
+    ChessUi ui(initialGame, engine, engineLimits, engineWhite, engineBlack);
+    ui.SetSavePath(savePath);
+    if (netPath) ui.SetNetwork(&network);
+    if (tbPath) ui.SetTablebase(&tablebase);
+    std::unique_ptr<PlayoutPool> playouts;
+    if (playoutThreads > 0) {
+        playouts.reset(new PlayoutPool(playoutThreads));
+        ui.SetPlayouts(playouts.get());
+    }
+    PolyglotBook book;
+    if (bookPath) {
+        if (!book.Open(bookPath)) {
+            fprintf(stderr, "Cannot open book %s\n", bookPath);
+            return 1;
+        }
+        ui.SetBook(&book, headless ? 0 : uint64_t(time(nullptr)));
+    }
 
-            // Highlight king if in check
-            if (IsInCheck(whiteTurn, pieces)) {
-                Piece* king = FindKing(whiteTurn, pieces);
-                if (king) {
-                    DrawRectangle(king->GetCol() * squareSize, king->GetRow() * squareSize, 
-                                squareSize, squareSize, Color{255, 0, 0, 80});
-                }
-            }
+    std::vector<UiScriptStep> script;
+    if (scriptPath && !LoadUiScript(scriptPath, script)) return 1;
+    size_t scriptStep = 0;
+    FrameProfiler profiler;
+    auto writeProfile = [&]() {
+        if (profilePath && !profiler.WriteTrace(profilePath)) fprintf(stderr, "Cannot write %s\n", profilePath);
+    };
+
+    if (headless) {
+        // Every script step is a frame without drawing
+        while (ui.Mode() != UiMode::Quit && scriptStep < script.size()) {
+            auto frameStart = std::chrono::steady_clock::now();
+            ui.Update(NextScriptInput(ui, script, scriptStep));
+            profiler.EndFrame(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+            if (ui.EngineTurn()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        writeProfile();
+        printf("%s\n", WriteFen(ui.Pos()).c_str());
+        printf("%s\n", ui.Status().outcome != Ongoing ? ui.Status().message : "Game in progress");
+        if (!ui.TablebaseVerdict().empty()) printf("%s\n", ui.TablebaseVerdict().c_str());
+        if (playouts) {
+            while (playouts->Refining()) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            PlayoutStats stats = playouts->Stats();
+            uint64_t total = std::max<uint64_t>(stats.Total(), 1);
+            printf("Playouts: W %.1f%% D %.1f%% L %.1f%% (%llu playouts, %.0f/sec)\n", 100.0 * stats.whiteWins / total,
+                   100.0 * stats.draws / total, 100.0 * stats.blackWins / total,
+                   (unsigned long long)stats.Total(), stats.playoutsPerSec);
+        }
+        return 0;
+    }
 
-            // Draw all pieces
-            for (auto* p : pieces) {
-                p->Draw(squareSize);
-            }
+    InitWindow(width + (playouts ? WdlBarWidth : 0), height, "Two-Player Chess");
+    SetTargetFPS(60);
+    SetExitKey(KEY_NULL);  // ESC is an input of the UI state machine
+    EnableEventWaiting();
+
+    // One texture for every piece, so the pieces are a single batched draw
+    Image atlasImage = LoadPieceAtlas("./Images");
+    Texture2D pieceAtlas = LoadTextureFromImage(atlasImage);
+    UnloadImage(atlasImage);
+
+    PawnTable pawnTable(256);  // H: passed pawns in gold, isolated/backward/doubled in red
+    // Static board and pieces, redrawn only when the UI marks it dirty
+    RenderTexture2D boardLayer = LoadRenderTexture(width, height);
+
+    while (!WindowShouldClose() && ui.Mode() != UiMode::Quit) {
+        auto frameStart = std::chrono::steady_clock::now();
+        // Input of this frame: the script while it lasts, then mouse and keyboard
+        UiInput input = scriptStep < script.size() ? NextScriptInput(ui, script, scriptStep) : ReadInput(squareSize);
+        ui.Update(input);
+
+        const Position& pos = ui.Pos();
+        if (ui.TakeBoardDirty()) {
+            DrawBoardLayer(boardLayer, pos, pieceAtlas, squareSize,
+                           ui.ShowPawnHints() ? &pawnTable.Probe(pos) : nullptr);
+        }
 
-            // Mouse handling
-            Vector2 mousePos = GetMousePosition();
-            int col = mousePos.x / squareSize;
-            int row = mousePos.y / squareSize;
-
-            if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                if (selectedPiece == nullptr) {
-                    // Select piece
-                    for (auto* p : pieces) {
-                        if (p->GetRow() == row && p->GetCol() == col) {
-                            if (p->IsWhite() == whiteTurn) {
-                                selectedPiece = p;
-                                selectedRow = row;
-                                selectedCol = col;
-                            }
-                            break;
-                        }
-                    }
-                } else {
-                    bool moveSuccessful = false;
-                    
-                    // CRITICAL FIX: Check if the king is in check
-                    bool currentlyInCheck = IsInCheck(whiteTurn, pieces);
-                    
-                    // Check if move would leave king in check OR doesn't resolve existing check
-                    bool wouldBeCheck = WouldBeInCheck(selectedPiece, row, col, whiteTurn, pieces);
-                    
-                    // NEW: If in check, the move MUST resolve the check
-                    bool isLegalMove = !wouldBeCheck;
-                    if (currentlyInCheck) {
-                        // When in check, only moves that get out of check are legal
-                        isLegalMove = DoesResolveCheck(selectedPiece, row, col, whiteTurn, pieces);
-                    }
-                    
-                    if (isLegalMove) {
-                        // Check for castling
-                        if (selectedPiece->GetName() == "King" && !selectedPiece->HasMoved() &&
-                            row == selectedRow && abs(col - selectedCol) == 2) {
-                            
-                            // Cannot castle while in check
-                            if (currentlyInCheck) {
-                                selectedPiece = nullptr;
-                                selectedRow = selectedCol = -1;
-                                EndDrawing();
-                                continue;
-                            }
-                            
-                            int rookCol = (col > selectedCol) ? 7 : 0;
-                            Piece* rook = FindPieceAt(row, rookCol, pieces);
-                            
-                            if (rook && rook->GetName() == "Rook" && !rook->HasMoved()) {
-                                // Check if path is clear
-                                int start = (rookCol == 0) ? 1 : 5;
-                                int end = (rookCol == 0) ? 4 : 7;
-                                bool pathClear = true;
-                                
-                                for (int c = start; c < end; c++) {
-                                    if (FindPieceAt(row, c, pieces) != nullptr) {
-                                        pathClear = false;
-                                        break;
-                                    }
-                                }
-                                
-                                // Check if king passes through or ends in check
-                                if (pathClear) {
-                                    int checkCols[] = {selectedCol, (selectedCol + col) / 2, col};
-                                    bool safe = true;
-                                    for (int c : checkCols) {
-                                        if (IsSquareUnderAttack(row, c, !whiteTurn, pieces)) {
-                                            safe = false;
-                                            break;
-                                        }
-                                    }
-                                    
-                                    if (safe) {
-                                        // Perform castling
-                                        selectedPiece->SetPosition(row, col);
-                                        int newRookCol = (col > selectedCol) ? col - 1 : col + 1;
-                                        rook->SetPosition(row, newRookCol);
-                                        moveSuccessful = true;
-                                        halfMoveClock++;
-                                    }
-                                }
-                            }
-                        }
-                        // Check for en passant
-                        else if (selectedPiece->GetName() == "Pawn" && 
-                                 abs(col - selectedCol) == 1 && 
-                                 FindPieceAt(row, col, pieces) == nullptr) {
-                            
-                            int captureRow = selectedRow;
-                            Piece* target = FindPieceAt(captureRow, col, pieces);
-                            
-                            if (target && target->GetName() == "Pawn" && 
-                                target->IsWhite() != whiteTurn) {
-                                
-                                Pawn* targetPawn = dynamic_cast<Pawn*>(target);
-                                if (targetPawn && targetPawn == lastDoubleStepPawn &&
-                                    targetPawn->GetLastMoveDoubleStep() == moveCounter - 1) {
-                                    
-                                    // Perform en passant
-                                    selectedPiece->SetPosition(row, col);
-                                    
-                                    // Remove captured pawn
-                                    for (int i = 0; i < pieces.size(); i++) {
-                                        if (pieces[i] == target) {
-                                            delete pieces[i];
-                                            pieces.erase(pieces.begin() + i);
-                                            break;
-                                        }
-                                    }
-                                    moveSuccessful = true;
-                                    halfMoveClock = 0; // Reset on capture
-                                }
-                            }
-                        }
-                        // Normal move
-                        else if (selectedPiece->IsMoveValid(row, col, pieces)) {
-                            Piece* target = FindPieceAt(row, col, pieces);
-                            
-                            if (target) {
-                                if (target->IsWhite() == selectedPiece->IsWhite()) {
-                                    // Same color - deselect
-                                    selectedPiece = nullptr;
-                                    selectedRow = selectedCol = -1;
-                                } else {
-                                    // Capture
-                                    for (int i = 0; i < pieces.size(); i++) {
-                                        if (pieces[i] == target) {
-                                            delete pieces[i];
-                                            pieces.erase(pieces.begin() + i);
-                                            break;
-                                        }
-                                    }
-                                    selectedPiece->SetPosition(row, col);
-                                    moveSuccessful = true;
-                                    halfMoveClock = 0; // Reset on capture
-                                }
-                            } else {
-                                // Empty square
-                                selectedPiece->SetPosition(row, col);
-                                moveSuccessful = true;
-                                
-                                // Pawn move resets half-move clock
-                                if (selectedPiece->GetName() == "Pawn") {
-                                    halfMoveClock = 0;
-                                } else {
-                                    halfMoveClock++;
-                                }
-                            }
-                        }
-                    }
-                    
-                    if (moveSuccessful) {
-                        // Track double-step pawns for en passant
-                        lastDoubleStepPawn = nullptr;
-                        if (selectedPiece->GetName() == "Pawn") {
-                            Pawn* pawn = dynamic_cast<Pawn*>(selectedPiece);
-                            if (abs(row - selectedRow) == 2) {
-                                pawn->SetLastMoveDoubleStep(moveCounter);
-                                lastDoubleStepPawn = pawn;
-                            }
-                            
-                            // Check for promotion
-                            int promotionRow = whiteTurn ? 0 : 7;
-                            if (row == promotionRow) {
-                                Texture2D promQueen = whiteTurn ? w_queen : b_queen;
-                                Texture2D promRook = whiteTurn ? w_rook : b_rook;
-                                Texture2D promBishop = whiteTurn ? w_bishop : b_bishop;
-                                Texture2D promKnight = whiteTurn ? w_knight : b_knight;
-                                
-                                ShowPromotionDialog(selectedPiece, pieces, 
-                                                  promQueen, promRook, promBishop, promKnight,
-                                                  squareSize);
-                            }
-                        }
-                        
-                        whiteTurn = !whiteTurn;
-                        moveCounter++;
-                    }
-                    
-                    selectedPiece = nullptr;
-                    selectedRow = selectedCol = -1;
-                }
-            }
+        BeginDrawing();
+        DrawLayer(boardLayer);
 
-            // Draw highlight if selected
-            if (selectedPiece != nullptr) {
-                DrawRectangle(selectedPiece->GetCol() * squareSize,
-                             selectedPiece->GetRow() * squareSize,
-                             squareSize, squareSize, Color{255, 215, 0, 60});
-                Rectangle rect = {
-                    (float)(selectedPiece->GetCol() * squareSize),
-                    (float)(selectedPiece->GetRow() * squareSize),
-                    (float)squareSize, (float)squareSize};
-                DrawRectangleLinesEx(rect, 3, GOLD);
-                
-                // Show valid moves for selected piece
-                bool currentlyInCheck = IsInCheck(whiteTurn, pieces);
-                
-                for (int r = 0; r < 8; r++) {
-                    for (int c = 0; c < 8; c++) {
-                        if (selectedPiece->IsMoveValid(r, c, pieces)) {
-                            Piece* target = FindPieceAt(r, c, pieces);
-                            if (!target || target->IsWhite() != selectedPiece->IsWhite()) {
-                                // Check if move is legal (doesn't leave in check)
-                                bool isLegal = false;
-                                if (currentlyInCheck) {
-                                    // Must resolve check
-                                    isLegal = DoesResolveCheck(selectedPiece, r, c, whiteTurn, pieces);
-                                } else {
-                                    // Must not put in check
-                                    isLegal = !WouldBeInCheck(selectedPiece, r, c, whiteTurn, pieces);
-                                }
-                                
-                                if (isLegal) {
-                                    // Draw small circle for valid moves
-                                    int centerX = c * squareSize + squareSize / 2;
-                                    int centerY = r * squareSize + squareSize / 2;
-                                    Color dotColor = target ? Color{255, 0, 0, 100} : Color{0, 255, 0, 100};
-                                    DrawCircle(centerX, centerY, 10, dotColor);
-                                }
-                            }
-                        }
-                    }
-                }
-            }
+        DrawHud(ui, width, height, squareSize);
 
-            // Display whose turn
-            const char* turnText = whiteTurn ? "White's Turn" : "Black's Turn";
-            DrawText(turnText, 10, 10, 20, whiteTurn ? WHITE : BLACK);
-            
-            // Display move counter
-            DrawText(TextFormat("Move: %d", moveCounter), 10, 35, 16, GRAY);
-            
-            // Display check status
-            if (IsInCheck(whiteTurn, pieces)) {
-                const char* checkText = "CHECK!";
-                int textWidth = MeasureText(checkText, 24);
-                DrawText(checkText, (width - textWidth) / 2, 10, 24, RED);
-            }
-            
-            // Display half-move clock
-            DrawText(TextFormat("50-move rule: %d/50", halfMoveClock / 2), 10, 60, 16, GRAY);
+        if (ui.Mode() == UiMode::Promoting) DrawPromotionOverlay(ui.PromotionChoice(), width, height);
+        if (ui.Mode() == UiMode::GameOver) DrawGameOverOverlay(ui.Status().message, width, height);
+        if (playouts) DrawWdlBar(playouts->Stats(), width, height);
+        if (ui.ShowProfile()) DrawProfileOverlay(profiler, width);
 
-            EndDrawing();
-        }
+        // Frame time is the work of building the frame, not the wait in EndDrawing
+        profiler.EndFrame(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
 
-        // Cleanup pieces for this game
-        for (auto* p : pieces) delete p;
-        
-        if (WindowShouldClose()) {
-            gameRunning = false;
+        // EndDrawing sleeps until the next input event, so an idle window costs nothing.
+        // A search finishing is not an input event, and neither is a script step: keep
+        // ticking at the target FPS while either is pending, or playouts are refining the bar.
+        if (ui.EngineTurn() || scriptStep < script.size() || (playouts && playouts->Refining())) {
+            DisableEventWaiting();
+        } else {
+            EnableEventWaiting();
         }
+        EndDrawing();
     }
 
-    // Unload textures
-    UnloadTexture(b_pawn);
-    UnloadTexture(b_rook);
-    UnloadTexture(b_knight);
-    UnloadTexture(b_bishop);
-    UnloadTexture(b_queen);
-    UnloadTexture(b_king);
-    UnloadTexture(w_pawn);
-    UnloadTexture(w_rook);
-    UnloadTexture(w_knight);
-    UnloadTexture(w_bishop);
-    UnloadTexture(w_queen);
-    UnloadTexture(w_king);
+    UnloadRenderTexture(boardLayer);
+    UnloadTexture(pieceAtlas);
     CloseWindow();
+    writeProfile();
     return 0;
-}
\ No newline at end of file
+}
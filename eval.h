@@ -0,0 +1,77 @@
+#pragma once
+#include "pawn.h"
+
+// Centipawn value of each piece type (the king is never traded); used for move ordering
+const int PieceValues[PieceTypeCount] = {100, 320, 330, 500, 900, 0};
+
+// Per square reached, relative to a typical count for the piece
+const Score MobilityWeight[PieceTypeCount] = {
+    0, MakeScore(4, 4), MakeScore(5, 5), MakeScore(2, 4), MakeScore(1, 2), 0,
+};
+const int MobilityAverage[PieceTypeCount] = {0, 4, 6, 7, 13, 0};
+
+// King safety: weight of each piece type attacking the squares around the enemy king
+const int KingAttackWeight[PieceTypeCount] = {0, 20, 20, 40, 80, 0};
+const Score PawnShield = MakeScore(10, 0);
+
+// Mobility of one side's pieces and the pressure they put on the enemy king
+inline Score EvaluatePieces(const Position& pos, Side side) {
+    Side them = Opposite(side);
+    Bitboard occupied = pos.Occupied();
+    Bitboard area = ~pos.bySide[side] & ~PawnAttacksAll(them, pos.Pieces(them, Pawn));
+    int enemyKing = pos.KingSquare(them);
+    Bitboard kingZone = enemyKing != NoSquare ? KingAttacks(enemyKing) | SquareBB(enemyKing) : 0;
+
+    Score score = 0;
+    int attackers = 0, attackWeight = 0;
+    for (int type = Knight; type <= Queen; type++) {
+        for (Bitboard b = pos.Pieces(side, PieceType(type)); b; ) {
+            int sq = PopLsb(b);
+            Bitboard attacks = type == Knight ? KnightAttacks(sq)
+                             : type == Bishop ? BishopAttacks(sq, occupied)
+                             : type == Rook   ? RookAttacks(sq, occupied)
+                                              : QueenAttacks(sq, occupied);
+            score += MobilityWeight[type] * (PopCount(attacks & area) - MobilityAverage[type]);
+            if (attacks & kingZone) {
+                attackers++;
+                attackWeight += KingAttackWeight[type] * PopCount(attacks & kingZone);
+            }
+        }
+    }
+    // One attacker is rarely dangerous; pressure grows with the number of pieces joining in
+    if (attackers >= 2) score += MakeScore(attackWeight * (attackers - 1) / 4, 0);
+
+    // Own pawns sheltering a king that stayed on its first two ranks
+    int king = pos.KingSquare(side);
+    int homeRank = side == White ? RankOf(king) : 7 - RankOf(king);
+    if (king != NoSquare && homeRank <= 1) {
+        Bitboard front = ForwardFile(side, king);
+        Bitboard shield = (front | ShiftEast(front) | ShiftWest(front)) &
+                          (side == White ? (Rank1 << 8 * (RankOf(king) + 1)) | (Rank1 << 8 * (RankOf(king) + 2))
+                                         : (Rank1 << 8 * (RankOf(king) - 1)) | (Rank1 << 8 * (RankOf(king) - 2)));
+        score += PawnShield * PopCount(shield & pos.Pieces(side, Pawn));
+    }
+    return score;
+}
+
+// Static score of the position from the side to move's point of view: material and
+// piece-square terms kept incrementally by Position, plus pawn structure, mobility and
+// king safety, blended between middlegame and endgame weights by the game phase.
+inline int Evaluate(const Position& pos, const PawnInfo& pawns) {
+    Score score = pos.psq + pawns.score;
+    score += EvaluatePieces(pos, White) - EvaluatePieces(pos, Black);
+    int phase = pos.phase < MaxPhase ? pos.phase : MaxPhase;
+    int value = (MgScore(score) * phase + EgScore(score) * (MaxPhase - phase)) / MaxPhase;
+    return pos.sideToMove == White ? value : -value;
+}
+
+inline int Evaluate(const Position& pos, PawnTable& pawnTable) {
+    return Evaluate(pos, pawnTable.Probe(pos));
+}
+
+// Uncached, for one-off calls outside the search
+inline int Evaluate(const Position& pos) {
+    PawnInfo pawns;
+    AnalyzePawns(pos, pawns);
+    return Evaluate(pos, pawns);
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include <algorithm>
+#include <string>
+#include <sstream>
+#include <cstring>
+#include "position.h"
+
+const char* const StartFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// FEN letter for each piece code
+const char PieceChars[] = "PNBRQKpnbrqk";
+
+// Fill pos from a FEN string; returns false (leaving pos unspecified) on malformed input
+inline bool ParseFen(const std::string& fen, Position& pos) {
+    std::istringstream in(fen);
+    std::string board, side, castling, ep;
+    int halfMoves = 0, fullMoves = 1;
+    if (!(in >> board >> side)) return false;
+    in >> castling >> ep;
+    if (!(in >> halfMoves)) halfMoves = 0;
+    if (!(in >> fullMoves)) fullMoves = 1;
+    if (halfMoves < 0 || fullMoves < 1) return false;
+
+    pos.Clear();
+    int file = 0, rank = 7;
+    for (char c : board) {
+        if (c == '/') {
+            if (file != 8) return false;
+            file = 0;
+            rank--;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+        } else {
+            const char* found = strchr(PieceChars, c);
+            if (!found || c == '\0' || file > 7 || rank < 0) return false;
+            // A pawn on the first or last rank has nowhere to move to
+            if ((c == 'P' || c == 'p') && (rank == 0 || rank == 7)) return false;
+            pos.PutPiece(Piece(found - PieceChars), MakeSquare(file, rank));
+            file++;
+        }
+        if (file > 8) return false;
+    }
+    if (rank != 0 || file != 8) return false;
+    if (PopCount(pos.Pieces(White, King)) != 1 || PopCount(pos.Pieces(Black, King)) != 1) return false;
+    // Every piece beyond the starting set must be a promoted pawn, which keeps a side
+    // to 16 pieces, the move count within MoveList and each 4-bit material count
+    for (Side s : {White, Black}) {
+        int pawns = PopCount(pos.Pieces(s, Pawn));
+        int promoted = std::max(PopCount(pos.Pieces(s, Knight)) - 2, 0) +
+                       std::max(PopCount(pos.Pieces(s, Bishop)) - 2, 0) +
+                       std::max(PopCount(pos.Pieces(s, Rook)) - 2, 0) +
+                       std::max(PopCount(pos.Pieces(s, Queen)) - 1, 0);
+        if (pawns > 8 || promoted > 8 - pawns) return false;
+    }
+
+    if (side == "w") pos.sideToMove = White;
+    else if (side == "b") pos.sideToMove = Black;
+    else return false;
+
+    for (char c : castling) {
+        switch (c) {
+            case 'K': pos.castling |= WhiteKingSide; break;
+            case 'Q': pos.castling |= WhiteQueenSide; break;
+            case 'k': pos.castling |= BlackKingSide; break;
+            case 'q': pos.castling |= BlackQueenSide; break;
+            case '-': break;
+            default: return false;
+        }
+    }
+    // Keep only the rights whose king and rook are still at home, so castling never
+    // moves a rook that is not there
+    const struct { CastlingRight right; int king, rook; Piece kingPiece, rookPiece; } homes[] = {
+        {WhiteKingSide, E1, H1, WhiteKing, WhiteRook}, {WhiteQueenSide, E1, A1, WhiteKing, WhiteRook},
+        {BlackKingSide, E8, H8, BlackKing, BlackRook}, {BlackQueenSide, E8, A8, BlackKing, BlackRook},
+    };
+    for (const auto& home : homes) {
+        if (pos.PieceOn(home.king) != home.kingPiece || pos.PieceOn(home.rook) != home.rookPiece) {
+            pos.castling &= ~home.right;
+        }
+    }
+
+    if (ep.size() == 2 && ep[0] >= 'a' && ep[0] <= 'h' && (ep[1] == '3' || ep[1] == '6')) {
+        pos.epSquare = MakeSquare(ep[0] - 'a', ep[1] - '1');
+    } else if (!ep.empty() && ep != "-") {
+        return false;
+    }
+
+    pos.halfMoveClock = halfMoves;
+    pos.fullMoveNumber = fullMoves;
+
+    // Only keep an en-passant square a double push could have left and a pawn can
+    // actually capture on: on the third rank of the side that just moved, with its
+    // pawn in front, and both it and the square the pawn came from empty. Equal
+    // positions then hash equally however the FEN was written, and MakeMove never
+    // takes a piece that is not a pawn en passant.
+    if (pos.epSquare != NoSquare) {
+        int ep = pos.epSquare;
+        Side us = pos.sideToMove, them = Opposite(us);
+        bool valid = RankOf(ep) == (us == White ? 5 : 2) &&
+                     pos.PieceOn(ep ^ 8) == MakePiece(them, Pawn) &&
+                     pos.PieceOn(ep) == NoPiece && pos.PieceOn(ep ^ 24) == NoPiece &&
+                     (PawnAttacks(them, ep) & pos.Pieces(us, Pawn));
+        if (!valid) pos.epSquare = NoSquare;
+    }
+    pos.key = pos.ComputeKey();
+
+    // The side that just moved may not be in check
+    pos.UpdateCheckInfo();
+    return !pos.InCheck(Opposite(pos.sideToMove));
+}
+
+// FEN string of pos; the en-passant field is only set when a capture is possible
+inline std::string WriteFen(const Position& pos) {
+    std::string fen;
+    for (int rank = 7; rank >= 0; rank--) {
+        int empty = 0;
+        for (int file = 0; file < 8; file++) {
+            Piece p = pos.PieceOn(MakeSquare(file, rank));
+            if (p == NoPiece) {
+                empty++;
+                continue;
+            }
+            if (empty) fen += char('0' + empty);
+            empty = 0;
+            fen += PieceChars[p];
+        }
+        if (empty) fen += char('0' + empty);
+        if (rank) fen += '/';
+    }
+    fen += pos.sideToMove == White ? " w " : " b ";
+    if (pos.castling & WhiteKingSide) fen += 'K';
+    if (pos.castling & WhiteQueenSide) fen += 'Q';
+    if (pos.castling & BlackKingSide) fen += 'k';
+    if (pos.castling & BlackQueenSide) fen += 'q';
+    if (!pos.castling) fen += '-';
+    fen += ' ';
+    if (pos.epSquare != NoSquare) {
+        fen += char('a' + FileOf(pos.epSquare));
+        fen += char('1' + RankOf(pos.epSquare));
+    } else {
+        fen += '-';
+    }
+    fen += ' ' + std::to_string(pos.halfMoveClock) + ' ' + std::to_string(pos.fullMoveNumber);
+    return fen;
+}
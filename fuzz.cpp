@@ -0,0 +1,452 @@
+// Random-game fuzzer for the rules code. Plays random legal games on every core and,
+// after every move, checks the position against its own invariants and against a
+// slow mailbox reference that shares no code with movegen.h: its own attack tests,
+// castling and en-passant bookkeeping, and move generation by make-and-test.
+// Build: g++ -O2 -std=c++17 fuzz.cpp -o chess-fuzz -pthread
+//
+//   chess-fuzz [--games N] [--threads N] [--seed S] [--plies N] [--fen FEN]
+//
+// On the first failure every thread stops, the game is shrunk to a short move
+// sequence that still fails, and the exit code is 1.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "fen.h"
+#include "movegen.h"
+
+// ---- Reference rules: a 64-square mailbox, nothing shared with movegen.h ----
+
+struct RefMove {
+    int from, to;
+    int promotion;  // PieceType, or -1
+    bool operator<(const RefMove& o) const {
+        return from != o.from ? from < o.from : to != o.to ? to < o.to : promotion < o.promotion;
+    }
+    bool operator==(const RefMove& o) const { return from == o.from && to == o.to && promotion == o.promotion; }
+};
+
+struct RefBoard {
+    Piece board[64];
+    Side side;
+    uint8_t castling;  // CastlingRight bits, kept from the moves played
+    int epTarget;      // Square a pawn skipped over last move, whether or not it can be taken
+};
+
+const int KnightSteps[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+const int KingSteps[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+
+// The square (file + df, rank + dr) from sq, or -1 off the board
+int RefStep(int sq, int df, int dr) {
+    int file = FileOf(sq) + df, rank = RankOf(sq) + dr;
+    return file >= 0 && file < 8 && rank >= 0 && rank < 8 ? MakeSquare(file, rank) : -1;
+}
+
+bool RefIs(const RefBoard& b, int sq, Side side, PieceType type) {
+    return sq >= 0 && b.board[sq] == MakePiece(side, type);
+}
+
+bool RefAttacked(const RefBoard& b, int sq, Side by) {
+    int pawnRank = by == White ? -1 : 1;  // Attacking pawns stand one rank behind, seen from `by`
+    if (RefIs(b, RefStep(sq, -1, pawnRank), by, Pawn) || RefIs(b, RefStep(sq, 1, pawnRank), by, Pawn)) return true;
+    for (const auto& s : KnightSteps) {
+        if (RefIs(b, RefStep(sq, s[0], s[1]), by, Knight)) return true;
+    }
+    for (const auto& s : KingSteps) {
+        if (RefIs(b, RefStep(sq, s[0], s[1]), by, King)) return true;
+        bool diagonal = s[0] != 0 && s[1] != 0;
+        for (int t = RefStep(sq, s[0], s[1]); t >= 0; t = RefStep(t, s[0], s[1])) {
+            if (b.board[t] == NoPiece) continue;
+            PieceType slider = diagonal ? Bishop : Rook;
+            if (RefIs(b, t, by, slider) || RefIs(b, t, by, Queen)) return true;
+            break;
+        }
+    }
+    return false;
+}
+
+int RefKing(const RefBoard& b, Side side) {
+    for (int sq = 0; sq < 64; sq++) {
+        if (b.board[sq] == MakePiece(side, King)) return sq;
+    }
+    return -1;
+}
+
+void RefApply(RefBoard& b, const RefMove& m) {
+    Piece piece = b.board[m.from];
+    bool pawn = TypeOf(piece) == Pawn;
+    if (pawn && m.to == b.epTarget && FileOf(m.from) != FileOf(m.to)) {
+        b.board[MakeSquare(FileOf(m.to), RankOf(m.from))] = NoPiece;  // The pawn taken en passant
+    }
+    if (TypeOf(piece) == King && abs(m.to - m.from) == 2) {
+        int rookFrom = m.to > m.from ? m.from + 3 : m.from - 4;
+        int rookTo = m.to > m.from ? m.from + 1 : m.from - 1;
+        b.board[rookTo] = b.board[rookFrom];
+        b.board[rookFrom] = NoPiece;
+    }
+    b.board[m.to] = m.promotion >= 0 ? MakePiece(b.side, PieceType(m.promotion)) : piece;
+    b.board[m.from] = NoPiece;
+    // A right goes once anything leaves or lands on its king's or rook's square
+    const struct { int sq; uint8_t rights; } homes[6] = {
+        {4, WhiteKingSide | WhiteQueenSide}, {7, WhiteKingSide}, {0, WhiteQueenSide},
+        {60, BlackKingSide | BlackQueenSide}, {63, BlackKingSide}, {56, BlackQueenSide},
+    };
+    for (const auto& h : homes) {
+        if (m.from == h.sq || m.to == h.sq) b.castling &= ~h.rights;
+    }
+    b.epTarget = pawn && abs(m.to - m.from) == 16 ? (m.from + m.to) / 2 : NoSquare;
+    b.side = Opposite(b.side);
+}
+
+// Every pseudo-legal move, kept if the mover's king is not attacked afterwards
+void RefMoves(const RefBoard& b, std::vector<RefMove>& out) {
+    out.clear();
+    Side us = b.side, them = Opposite(us);
+    std::vector<RefMove> pseudo;
+    auto add = [&](int from, int to) {
+        bool promotes = TypeOf(b.board[from]) == Pawn && (RankOf(to) == 0 || RankOf(to) == 7);
+        if (!promotes) {
+            pseudo.push_back({from, to, -1});
+            return;
+        }
+        for (PieceType t : {Queen, Rook, Bishop, Knight}) pseudo.push_back({from, to, t});
+    };
+    auto enemyOrEmpty = [&](int sq) { return sq >= 0 && (b.board[sq] == NoPiece || SideOf(b.board[sq]) == them); };
+
+    for (int sq = 0; sq < 64; sq++) {
+        Piece p = b.board[sq];
+        if (p == NoPiece || SideOf(p) != us) continue;
+        switch (TypeOf(p)) {
+            case Pawn: {
+                int dr = us == White ? 1 : -1;
+                int one = RefStep(sq, 0, dr);
+                if (one >= 0 && b.board[one] == NoPiece) {
+                    add(sq, one);
+                    int startRank = us == White ? 1 : 6;
+                    int two = RefStep(sq, 0, 2 * dr);
+                    if (RankOf(sq) == startRank && b.board[two] == NoPiece) add(sq, two);
+                }
+                for (int df : {-1, 1}) {
+                    int t = RefStep(sq, df, dr);
+                    if (t < 0) continue;
+                    if ((b.board[t] != NoPiece && SideOf(b.board[t]) == them) || t == b.epTarget) add(sq, t);
+                }
+                break;
+            }
+            case Knight:
+                for (const auto& s : KnightSteps) {
+                    if (enemyOrEmpty(RefStep(sq, s[0], s[1]))) add(sq, RefStep(sq, s[0], s[1]));
+                }
+                break;
+            case King:
+                for (const auto& s : KingSteps) {
+                    if (enemyOrEmpty(RefStep(sq, s[0], s[1]))) add(sq, RefStep(sq, s[0], s[1]));
+                }
+                break;
+            default:
+                for (const auto& s : KingSteps) {
+                    bool diagonal = s[0] != 0 && s[1] != 0;
+                    if ((TypeOf(p) == Bishop && !diagonal) || (TypeOf(p) == Rook && diagonal)) continue;
+                    for (int t = RefStep(sq, s[0], s[1]); t >= 0; t = RefStep(t, s[0], s[1])) {
+                        if (b.board[t] != NoPiece && SideOf(b.board[t]) == us) break;
+                        add(sq, t);
+                        if (b.board[t] != NoPiece) break;
+                    }
+                }
+                break;
+        }
+    }
+
+    // Castling: the right, an empty path, and no attacked square from the king's start to its target
+    int home = us == White ? 4 : 60;
+    const struct { uint8_t right; int rook; int empty[3]; int passes[3]; } sides[2] = {
+        {uint8_t(us == White ? WhiteKingSide : BlackKingSide), home + 3, {home + 1, home + 2, -1}, {home, home + 1, home + 2}},
+        {uint8_t(us == White ? WhiteQueenSide : BlackQueenSide), home - 4, {home - 1, home - 2, home - 3}, {home, home - 1, home - 2}},
+    };
+    for (const auto& c : sides) {
+        if (!(b.castling & c.right) || !RefIs(b, home, us, King) || !RefIs(b, c.rook, us, Rook)) continue;
+        bool ok = true;
+        for (int sq : c.empty) ok = ok && (sq < 0 || b.board[sq] == NoPiece);
+        for (int sq : c.passes) ok = ok && !RefAttacked(b, sq, them);
+        if (ok) pseudo.push_back({home, c.passes[2], -1});
+    }
+
+    for (const RefMove& m : pseudo) {
+        RefBoard next = b;
+        RefApply(next, m);
+        int king = RefKing(next, us);
+        if (king >= 0 && !RefAttacked(next, king, them)) out.push_back(m);
+    }
+    std::sort(out.begin(), out.end());
+}
+
+RefBoard RefFromPosition(const Position& pos) {
+    RefBoard b;
+    memcpy(b.board, pos.board, sizeof(b.board));
+    b.side = pos.sideToMove;
+    b.castling = pos.castling;
+    b.epTarget = pos.epSquare;
+    return b;
+}
+
+RefMove ToRef(Move m) {
+    return {MoveFrom(m), MoveTo(m), IsPromotion(m) ? int(PromotionType(m)) : -1};
+}
+
+// ---- Invariants ----
+
+// The name of the first field that differs, or nullptr
+const char* DiffPositions(const Position& a, const Position& b) {
+    if (memcmp(a.board, b.board, sizeof(a.board)) != 0) return "board";
+    if (memcmp(a.pieces, b.pieces, sizeof(a.pieces)) != 0) return "pieces";
+    if (a.bySide[White] != b.bySide[White] || a.bySide[Black] != b.bySide[Black]) return "bySide";
+    if (a.sideToMove != b.sideToMove) return "sideToMove";
+    if (a.castling != b.castling) return "castling";
+    if (a.epSquare != b.epSquare) return "epSquare";
+    if (a.halfMoveClock != b.halfMoveClock) return "halfMoveClock";
+    if (a.fullMoveNumber != b.fullMoveNumber) return "fullMoveNumber";
+    if (a.checkers != b.checkers) return "checkers";
+    if (a.pinned != b.pinned) return "pinned";
+    if (a.key != b.key) return "key";
+    if (a.pawnKey != b.pawnKey) return "pawnKey";
+    if (a.material != b.material) return "material";
+    if (a.psq != b.psq) return "psq";
+    if (a.phase != b.phase) return "phase";
+    return nullptr;
+}
+
+// Everything that must hold in pos, which the reference has followed move by move.
+// Returns an empty string when all is well.
+std::string CheckPosition(const Position& pos, const RefBoard& ref) {
+    // The board itself, against the mailbox the reference moved independently
+    if (memcmp(pos.board, ref.board, sizeof(ref.board)) != 0) return "board differs from the reference";
+    if (pos.sideToMove != ref.side) return "side to move differs from the reference";
+    if (pos.castling != ref.castling) return "castling rights differ from the reference";
+
+    // Redundant representations agree with the mailbox
+    Position fresh;
+    fresh.Clear();
+    for (int sq = 0; sq < 64; sq++) {
+        if (pos.board[sq] != NoPiece) fresh.PutPiece(pos.board[sq], sq);
+    }
+    if (memcmp(pos.pieces, fresh.pieces, sizeof(fresh.pieces)) != 0) return "piece bitboards disagree with the board";
+    if (pos.bySide[White] != fresh.bySide[White] || pos.bySide[Black] != fresh.bySide[Black]) return "side bitboards disagree with the board";
+    if (pos.pawnKey != fresh.pawnKey) return "incremental pawn key is wrong";
+    if (pos.material != fresh.material) return "material signature is wrong";
+    if (pos.psq != pos.ComputePsq()) return "incremental piece-square score is wrong";
+    if (pos.phase != fresh.phase) return "phase is wrong";
+    if (pos.key != pos.ComputeKey()) return "incremental key is wrong";
+
+    for (Side side : {White, Black}) {
+        if (PopCount(pos.Pieces(side, King)) != 1) return "not exactly one king per side";
+    }
+    if (pos.Pieces(Pawn) & (Rank1 | Rank8)) return "pawn on the first or last rank";
+    // A castling right needs its king and rook at home
+    const struct { uint8_t right; int king, rook; Piece kingPiece, rookPiece; } rights[4] = {
+        {WhiteKingSide, 4, 7, WhiteKing, WhiteRook}, {WhiteQueenSide, 4, 0, WhiteKing, WhiteRook},
+        {BlackKingSide, 60, 63, BlackKing, BlackRook}, {BlackQueenSide, 60, 56, BlackKing, BlackRook},
+    };
+    for (const auto& r : rights) {
+        if ((pos.castling & r.right) && (pos.board[r.king] != r.kingPiece || pos.board[r.rook] != r.rookPiece)) {
+            return "castling right without king and rook at home";
+        }
+    }
+
+    Side us = pos.sideToMove, them = Opposite(us);
+    if (RefAttacked(ref, RefKing(ref, them), us)) return "the side that just moved is in check";
+    if ((pos.checkers != 0) != RefAttacked(ref, RefKing(ref, us), them)) return "checkers disagree with the reference";
+
+    // The en-passant square is recorded exactly when a pawn of the side to move attacks it
+    int expectedEp = NoSquare;
+    if (ref.epTarget != NoSquare) {
+        int behind = us == White ? -1 : 1;
+        for (int df : {-1, 1}) {
+            if (RefIs(ref, RefStep(ref.epTarget, df, behind), us, Pawn)) expectedEp = ref.epTarget;
+        }
+    }
+    if (pos.epSquare != expectedEp) return "en-passant square differs from the reference";
+
+    // Legal moves agree with the reference
+    MoveList moves;
+    GenerateMoves(pos, moves);
+    std::vector<RefMove> ours, theirs;
+    for (Move m : moves) ours.push_back(ToRef(m));
+    std::sort(ours.begin(), ours.end());
+    RefMoves(ref, theirs);
+    if (ours != theirs) {
+        std::string diff;
+        for (const RefMove& m : ours) {
+            if (!std::binary_search(theirs.begin(), theirs.end(), m)) diff += " +" + MoveToUci(EncodeMove(m.from, m.to, Quiet));
+        }
+        for (const RefMove& m : theirs) {
+            if (!std::binary_search(ours.begin(), ours.end(), m)) diff += " -" + MoveToUci(EncodeMove(m.from, m.to, Quiet));
+        }
+        return "legal moves differ from the reference (+extra -missing):" + diff;
+    }
+
+    // Trying any move and taking it back restores every field
+    for (Move m : moves) {
+        Position trial = pos;
+        UndoInfo undo;
+        MakeMove(trial, m, undo);
+        if (trial.key != trial.ComputeKey()) return "key wrong after " + MoveToUci(m);
+        UnmakeMove(trial, m, undo);
+        if (const char* field = DiffPositions(pos, trial)) {
+            return std::string(field) + " not restored after making and unmaking " + MoveToUci(m);
+        }
+    }
+    return "";
+}
+
+// ---- Games ----
+
+enum ReplayResult { ReplayPasses, ReplayFails, ReplayIllegal };
+
+// Play moves from start, checking after each; on failure `moves` is cut back to the
+// failing prefix and `error` says what broke
+ReplayResult Replay(const Position& start, std::vector<Move>& moves, std::string& error) {
+    Position pos = start;
+    RefBoard ref = RefFromPosition(start);
+    error = CheckPosition(pos, ref);
+    if (!error.empty()) {
+        moves.clear();
+        return ReplayFails;
+    }
+    for (size_t i = 0; i < moves.size(); i++) {
+        MoveList legal;
+        GenerateMoves(pos, legal);
+        Move m = FindMove(legal, MoveFrom(moves[i]), MoveTo(moves[i]),
+                          IsPromotion(moves[i]) ? PromotionType(moves[i]) : Queen);
+        if (m == NullMove) return ReplayIllegal;
+        UndoInfo undo;
+        MakeMove(pos, m, undo);
+        RefApply(ref, ToRef(m));
+        error = CheckPosition(pos, ref);
+        if (!error.empty()) {
+            moves.resize(i + 1);
+            return ReplayFails;
+        }
+    }
+    return ReplayPasses;
+}
+
+// Drop moves while the sequence stays legal and still fails: pairs first, which keep
+// the side to move of the failing position, then single moves
+void Shrink(const Position& start, std::vector<Move>& moves, std::string& error) {
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (int width : {2, 1}) {
+            for (size_t i = 0; i + width <= moves.size();) {
+                std::vector<Move> candidate = moves;
+                candidate.erase(candidate.begin() + i, candidate.begin() + i + width);
+                std::string candidateError;
+                if (Replay(start, candidate, candidateError) == ReplayFails) {
+                    moves = candidate;
+                    error = candidateError;
+                    changed = true;
+                } else {
+                    i++;
+                }
+            }
+        }
+    }
+}
+
+struct Failure {
+    uint64_t game;
+    std::vector<Move> moves;
+    std::string error;
+};
+
+int main(int argc, char** argv) {
+    uint64_t games = 100000;
+    uint64_t seed = 1;
+    int threads = int(std::thread::hardware_concurrency());
+    int maxPlies = 400;
+    const char* fen = nullptr;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--games") == 0 && hasValue) games = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && hasValue) seed = strtoull(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--plies") == 0 && hasValue) maxPlies = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--fen") == 0 && hasValue) fen = argv[++i];
+        else {
+            fprintf(stderr, "Usage: %s [--games N] [--threads N] [--seed S] [--plies N] [--fen FEN]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (threads < 1) threads = 1;
+
+    Position start;
+    start.SetStartPosition();
+    if (fen && !ParseFen(fen, start)) {
+        fprintf(stderr, "Invalid FEN: %s\n", fen);
+        return 2;
+    }
+
+    // Game g always uses the random stream seeded from (seed, g), so a failure is
+    // reproducible whichever thread happened to play it
+    std::atomic<uint64_t> nextGame{0}, plies{0}, played{0};
+    std::atomic<bool> failed{false};
+    std::mutex failureMutex;
+    Failure failure;
+    auto worker = [&]() {
+        std::vector<Move> moves;
+        moves.reserve(maxPlies);
+        for (uint64_t g = nextGame++; g < games && !failed; g = nextGame++) {
+            uint64_t random = seed * 0x9E3779B97F4A7C15ULL + g;
+            Position pos = start;
+            RefBoard ref = RefFromPosition(start);
+            moves.clear();
+            std::string error = CheckPosition(pos, ref);
+            for (int ply = 0; error.empty() && ply < maxPlies; ply++) {
+                MoveList legal;
+                GenerateMoves(pos, legal);
+                if (legal.Size() == 0 || pos.halfMoveClock >= 100) break;
+                Move m = legal[int(SplitMix64(random) % uint64_t(legal.Size()))];
+                UndoInfo undo;
+                MakeMove(pos, m, undo);
+                RefApply(ref, ToRef(m));
+                moves.push_back(m);
+                error = CheckPosition(pos, ref);
+            }
+            plies += moves.size();
+            played++;
+            if (!error.empty()) {
+                std::lock_guard<std::mutex> lock(failureMutex);
+                if (!failed.exchange(true)) failure = {g, moves, error};
+            }
+        }
+    };
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) workers.emplace_back(worker);
+    for (auto& t : workers) t.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    if (seconds <= 0) seconds = 1e-9;
+
+    printf("%llu games, %llu plies with %d threads in %.2fs: %.0f games/sec, %.0f plies/sec\n",
+           (unsigned long long)played, (unsigned long long)plies, threads, seconds, played / seconds, plies / seconds);
+    if (!failed) return 0;
+
+    printf("FAILED in game %llu (seed %llu) after %zu plies: %s\n", (unsigned long long)failure.game,
+           (unsigned long long)seed, failure.moves.size(), failure.error.c_str());
+    Shrink(start, failure.moves, failure.error);
+    Position pos = start;
+    std::string line;
+    for (Move m : failure.moves) {
+        line += " " + MoveToUci(m);
+        UndoInfo undo;
+        MakeMove(pos, m, undo);
+    }
+    printf("Shrunk to %zu plies from %s:\n %s\n", failure.moves.size(), WriteFen(start).c_str(), line.c_str());
+    printf("Failing position: %s\n%s\n", WriteFen(pos).c_str(), failure.error.c_str());
+    return 1;
+}
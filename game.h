@@ -0,0 +1,132 @@
+#pragma once
+#include <initializer_list>
+#include <vector>
+#include "movegen.h"
+
+const Bitboard LightSquares = 0x55AA55AA55AA55AAULL;
+
+constexpr uint64_t Signature(std::initializer_list<Piece> pieces) {
+    uint64_t sig = 0;
+    for (Piece p : pieces) sig += MaterialUnit(p);
+    return sig;
+}
+
+const uint64_t KingFields = 0xFULL << (4 * WhiteKing) | 0xFULL << (4 * BlackKing);
+constexpr uint64_t BishopEach = Signature({WhiteBishop, BlackBishop});
+
+// Material signatures (kings excluded) where neither side can ever mate
+constexpr uint64_t DeadSignatures[] = {
+    0,                                          // K v K
+    Signature({WhiteKnight}), Signature({BlackKnight}),
+    Signature({WhiteBishop}), Signature({BlackBishop}),
+};
+
+// Knight pairs the GUI also scores as drawn. A GUI convention, not FIDE: mate is
+// possible in both, just never forced, and the GUI has always called them drawn.
+constexpr uint64_t KnightPairSignatures[] = {
+    Signature({WhiteKnight, WhiteKnight}),
+    Signature({WhiteKnight, BlackKnight}),
+    Signature({BlackKnight, BlackKnight}),
+};
+
+// FIDE dead position by material alone: a lookup of the material signature
+inline bool IsDeadPosition(const Position& pos) {
+    uint64_t sig = pos.material & ~KingFields;
+    for (uint64_t dead : DeadSignatures) {
+        if (sig == dead) return true;
+    }
+    // King + Bishop vs King + Bishop (same color squares)
+    if (sig == BishopEach) {
+        Bitboard bishops = pos.Pieces(Bishop);
+        return !(bishops & LightSquares) || !(bishops & ~LightSquares);
+    }
+    return false;
+}
+
+// Check for insufficient material draw as the GUI scores it: the FIDE dead
+// positions plus the knight pairs
+inline bool IsInsufficientMaterial(const Position& pos) {
+    PROFILE_SCOPE(ProfileInsufficientMaterial);
+    uint64_t sig = pos.material & ~KingFields;
+    for (uint64_t pair : KnightPairSignatures) {
+        if (sig == pair) return true;
+    }
+    return IsDeadPosition(pos);
+}
+
+// Number of earlier positions in keys (oldest first, the current position last)
+// equal to the current one. Only positions since the last capture or pawn move
+// can repeat, and only every other ply has the same side to move.
+inline int CountRepetitions(const Key* keys, int count, int halfMoveClock) {
+    if (count == 0) return 0;
+    Key current = keys[count - 1];
+    int stop = count - 1 - halfMoveClock;
+    if (stop < 0) stop = 0;
+    int repetitions = 0;
+    for (int i = count - 3; i >= stop; i -= 2) {
+        if (keys[i] == current) repetitions++;
+    }
+    return repetitions;
+}
+
+// Check for stalemate or checkmate, given the legal moves of the position
+inline bool IsCheckmate(const Position& pos, const MoveList& legalMoves) {
+    return pos.checkers && legalMoves.Size() == 0;
+}
+
+inline bool IsStalemate(const Position& pos, const MoveList& legalMoves) {
+    return !pos.checkers && legalMoves.Size() == 0;
+}
+
+enum GameOutcome {
+    Ongoing,
+    WhiteWins,
+    BlackWins,
+    Draw
+};
+
+struct GameStatus {
+    GameOutcome outcome;
+    const char* message;
+};
+
+// A game as played from its start position: the moves so far, the current position
+// and the key of every position reached, for repetition detection
+struct Game {
+    Position start;
+    Position pos;
+    std::vector<Move> moves;
+    std::vector<Key> keys;
+
+    // Clears the move and key history but keeps their capacity for reuse
+    void Reset(const Position& startPos) {
+        start = pos = startPos;
+        moves.clear();
+        keys.clear();
+        keys.push_back(pos.key);
+    }
+
+    void Play(Move m) {
+        UndoInfo undo;
+        MakeMove(pos, m, undo);
+        moves.push_back(m);
+        keys.push_back(pos.key);
+    }
+
+    int Repetitions() const { return CountRepetitions(keys.data(), int(keys.size()), pos.halfMoveClock); }
+
+    // Mate and stalemate, insufficient material as the GUI scores it (FIDE dead
+    // positions plus the knight pairs), threefold repetition and the 50-move rule
+    GameStatus Status(const MoveList& legalMoves) const {
+        PROFILE_SCOPE(ProfileGameStatus);
+        if (IsCheckmate(pos, legalMoves)) {
+            return pos.sideToMove == White ? GameStatus{BlackWins, "Black wins by checkmate!"}
+                                           : GameStatus{WhiteWins, "White wins by checkmate!"};
+        }
+        if (IsStalemate(pos, legalMoves)) return {Draw, "Draw by stalemate!"};
+        if (IsInsufficientMaterial(pos)) return {Draw, "Draw by insufficient material!"};
+        if (Repetitions() >= 2) return {Draw, "Draw by threefold repetition!"};
+        if (pos.halfMoveClock >= 100) return {Draw, "Draw by 50-move rule!"}; // 50 moves = 100 half-moves
+        return {Ongoing, nullptr};
+    }
+};
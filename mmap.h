@@ -0,0 +1,59 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstddef>
+#include <utility>
+
+// A read-only memory-mapped file. Pages are read in on demand and shared through the
+// page cache, so a multi-gigabyte archive streams through without being loaded and
+// processes opening the same file share one copy. `advice` is passed to madvise:
+// MADV_SEQUENTIAL for streaming, MADV_RANDOM for lookups, MADV_WILLNEED to preload.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { Close(); }
+
+    bool Open(const char* path, int advice = MADV_SEQUENTIAL) {
+        Close();
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        bool ok = fstat(fd, &st) == 0;
+        if (ok && st.st_size > 0) {
+            void* p = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ok = false;
+            } else {
+                base = static_cast<const char*>(p);
+                length = size_t(st.st_size);
+                madvise(p, length, advice);
+            }
+        }
+        close(fd);
+        return ok;
+    }
+
+    void Close() {
+        if (base) munmap(const_cast<char*>(base), length);
+        base = nullptr;
+        length = 0;
+    }
+
+    // Exchange mappings, so a replacement can be opened and checked before the
+    // current one is given up
+    void Swap(MappedFile& other) {
+        std::swap(base, other.base);
+        std::swap(length, other.length);
+    }
+
+    const char* Data() const { return base; }
+    size_t Size() const { return length; }
+
+private:
+    const char* base = nullptr;
+    size_t length = 0;
+};
@@ -0,0 +1,69 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include "piece.h"
+
+// 16-bit move: bits 0-5 from square, bits 6-11 to square, bits 12-15 flags
+typedef uint16_t Move;
+
+const Move NullMove = 0;
+
+enum MoveFlag : int {
+    Quiet = 0,
+    DoublePush = 1,
+    KingCastle = 2,
+    QueenCastle = 3,
+    Capture = 4,
+    EnPassant = 5,
+    PromoteKnight = 8,   // Promotions: 8 + (type - Knight), +4 when capturing
+    PromoteBishop = 9,
+    PromoteRook = 10,
+    PromoteQueen = 11,
+    PromoteKnightCapture = 12,
+    PromoteBishopCapture = 13,
+    PromoteRookCapture = 14,
+    PromoteQueenCapture = 15
+};
+
+inline Move EncodeMove(int from, int to, int flags = Quiet) {
+    return Move(from | (to << 6) | (flags << 12));
+}
+
+inline int MoveFrom(Move m) { return m & 63; }
+inline int MoveTo(Move m) { return (m >> 6) & 63; }
+inline int MoveFlags(Move m) { return m >> 12; }
+inline bool IsCapture(Move m) { return (MoveFlags(m) & Capture) != 0; }
+inline bool IsPromotion(Move m) { return (MoveFlags(m) & 8) != 0; }
+inline bool IsCastle(Move m) { return MoveFlags(m) == KingCastle || MoveFlags(m) == QueenCastle; }
+inline PieceType PromotionType(Move m) { return PieceType(Knight + (MoveFlags(m) & 3)); }
+
+// Long algebraic notation as used by UCI, e.g. "e2e4" or "e7e8q"
+inline std::string MoveToUci(Move m) {
+    if (m == NullMove) return "0000";
+    std::string s;
+    s += char('a' + (MoveFrom(m) & 7));
+    s += char('1' + (MoveFrom(m) >> 3));
+    s += char('a' + (MoveTo(m) & 7));
+    s += char('1' + (MoveTo(m) >> 3));
+    if (IsPromotion(m)) s += "nbrq"[PromotionType(m) - Knight];
+    return s;
+}
+
+// Fixed-capacity move buffer that lives on the stack (218 is the known maximum)
+struct MoveList {
+    Move moves[256];
+    int count = 0;
+
+    void Add(Move m) {
+        assert(count < 256);
+        moves[count++] = m;
+    }
+    void Clear() { count = 0; }
+    int Size() const { return count; }
+    Move operator[](int i) const { return moves[i]; }
+    Move* begin() { return moves; }
+    Move* end() { return moves + count; }
+    const Move* begin() const { return moves; }
+    const Move* end() const { return moves + count; }
+};
@@ -0,0 +1,246 @@
+#pragma once
+#include "position.h"
+#include "move.h"
+#include "profile.h"
+
+// Everything MakeMove overwrites that cannot be recomputed from the move itself
+struct UndoInfo {
+    Piece captured;
+    uint8_t castling;
+    int epSquare;
+    int halfMoveClock;
+    Bitboard checkers;
+    Bitboard pinned;
+    Key key;
+};
+
+// Castling rights lost when a piece leaves or lands on each square
+inline uint8_t CastlingLostOn(int sq) {
+    switch (sq) {
+        case E1: return WhiteKingSide | WhiteQueenSide;
+        case H1: return WhiteKingSide;
+        case A1: return WhiteQueenSide;
+        case E8: return BlackKingSide | BlackQueenSide;
+        case H8: return BlackKingSide;
+        case A8: return BlackQueenSide;
+        default: return 0;
+    }
+}
+
+// Add one move per target square, marking captures
+inline void AddMoves(MoveList& list, int from, Bitboard targets, Bitboard enemies) {
+    while (targets) {
+        int to = PopLsb(targets);
+        list.Add(EncodeMove(from, to, (enemies & SquareBB(to)) ? Capture : Quiet));
+    }
+}
+
+inline void AddPromotions(MoveList& list, int from, int to, bool capture) {
+    int base = capture ? PromoteKnightCapture : PromoteKnight;
+    for (int i = 3; i >= 0; i--) list.Add(EncodeMove(from, to, base + i)); // Queen first
+}
+
+inline void MakeMove(Position& pos, Move m, UndoInfo& undo) {
+    PROFILE_SCOPE(ProfileMakeMove);
+    int from = MoveFrom(m);
+    int to = MoveTo(m);
+    int flags = MoveFlags(m);
+    Side us = pos.sideToMove;
+    Piece piece = pos.PieceOn(from);
+
+    undo.captured = NoPiece;
+    undo.castling = pos.castling;
+    undo.epSquare = pos.epSquare;
+    undo.halfMoveClock = pos.halfMoveClock;
+    undo.checkers = pos.checkers;
+    undo.pinned = pos.pinned;
+    undo.key = pos.key;
+
+    if (flags == EnPassant) {
+        undo.captured = MakePiece(Opposite(us), Pawn);
+        pos.RemovePiece(undo.captured, to ^ 8); // The captured pawn sits behind the target square
+    } else if (IsCapture(m)) {
+        undo.captured = pos.PieceOn(to);
+        pos.RemovePiece(undo.captured, to);
+    }
+
+    pos.RemovePiece(piece, from);
+    pos.PutPiece(IsPromotion(m) ? MakePiece(us, PromotionType(m)) : piece, to);
+
+    if (flags == KingCastle) {
+        pos.RemovePiece(MakePiece(us, Rook), to + 1);
+        pos.PutPiece(MakePiece(us, Rook), to - 1);
+    } else if (flags == QueenCastle) {
+        pos.RemovePiece(MakePiece(us, Rook), to - 2);
+        pos.PutPiece(MakePiece(us, Rook), to + 1);
+    }
+
+    pos.halfMoveClock = (TypeOf(piece) == Pawn || undo.captured != NoPiece) ? 0 : pos.halfMoveClock + 1;
+
+    // The en-passant square is only recorded (and hashed) when an enemy pawn can use it
+    if (pos.epSquare != NoSquare) pos.key ^= Zobrist.epFile[FileOf(pos.epSquare)];
+    pos.epSquare = NoSquare;
+    if (flags == DoublePush && (PawnAttacks(us, (from + to) / 2) & pos.Pieces(Opposite(us), Pawn))) {
+        pos.epSquare = (from + to) / 2;
+        pos.key ^= Zobrist.epFile[FileOf(pos.epSquare)];
+    }
+
+    pos.key ^= Zobrist.castling[pos.castling];
+    pos.castling &= ~(CastlingLostOn(from) | CastlingLostOn(to));
+    pos.key ^= Zobrist.castling[pos.castling];
+
+    if (us == Black) pos.fullMoveNumber++;
+    pos.sideToMove = Opposite(us);
+    pos.key ^= Zobrist.side;
+    pos.UpdateCheckInfo();
+}
+
+inline void UnmakeMove(Position& pos, Move m, const UndoInfo& undo) {
+    int from = MoveFrom(m);
+    int to = MoveTo(m);
+    int flags = MoveFlags(m);
+    Side us = Opposite(pos.sideToMove);
+    pos.sideToMove = us;
+    if (us == Black) pos.fullMoveNumber--;
+
+    Piece moved = IsPromotion(m) ? MakePiece(us, Pawn) : pos.PieceOn(to);
+    pos.RemovePiece(pos.PieceOn(to), to);
+    pos.PutPiece(moved, from);
+
+    if (flags == KingCastle) {
+        pos.RemovePiece(MakePiece(us, Rook), to - 1);
+        pos.PutPiece(MakePiece(us, Rook), to + 1);
+    } else if (flags == QueenCastle) {
+        pos.RemovePiece(MakePiece(us, Rook), to + 1);
+        pos.PutPiece(MakePiece(us, Rook), to - 2);
+    }
+
+    if (flags == EnPassant) {
+        pos.PutPiece(undo.captured, to ^ 8);
+    } else if (undo.captured != NoPiece) {
+        pos.PutPiece(undo.captured, to);
+    }
+
+    pos.castling = undo.castling;
+    pos.epSquare = undo.epSquare;
+    pos.halfMoveClock = undo.halfMoveClock;
+    pos.checkers = undo.checkers;
+    pos.pinned = undo.pinned;
+    pos.key = undo.key;
+}
+
+// Legal moves only. Uses the position's checkers and pinned masks, so no move is
+// ever played to test it: evasions are limited to capturing or blocking a single
+// checker, pinned pieces stay on the line to their king, and king moves are
+// checked against attacks with the king lifted off the board.
+inline void GenerateMoves(const Position& pos, MoveList& list) {
+    PROFILE_SCOPE(ProfileGenerateMoves);
+    Side us = pos.sideToMove;
+    Side them = Opposite(us);
+    Bitboard own = pos.bySide[us];
+    Bitboard enemies = pos.bySide[them];
+    Bitboard occupied = own | enemies;
+    int king = pos.KingSquare(us);
+    if (king == NoSquare) return;
+
+    // King steps
+    Bitboard withoutKing = occupied ^ SquareBB(king);
+    for (Bitboard b = KingAttacks(king) & ~own; b; ) {
+        int to = PopLsb(b);
+        if (!(pos.AttackersTo(to, withoutKing) & enemies)) {
+            list.Add(EncodeMove(king, to, (enemies & SquareBB(to)) ? Capture : Quiet));
+        }
+    }
+    if (PopCount(pos.checkers) > 1) return; // Double check: only the king can move
+
+    // Squares a non-king move may land on
+    Bitboard allowed = pos.checkers ? (Between(king, Lsb(pos.checkers)) | pos.checkers) : ~own;
+    auto restrict = [&](int from, Bitboard targets) {
+        targets &= allowed;
+        if (pos.pinned & SquareBB(from)) targets &= Line(king, from);
+        return targets;
+    };
+
+    // Pawns
+    int forward = us == White ? 8 : -8;
+    Bitboard promotionRank = us == White ? Rank8 : Rank1;
+    int startRank = us == White ? 1 : 6;
+    for (Bitboard b = pos.Pieces(us, Pawn); b; ) {
+        int from = PopLsb(b);
+        int to = from + forward;
+        if (!(occupied & SquareBB(to))) {
+            if (restrict(from, SquareBB(to))) {
+                if (SquareBB(to) & promotionRank) AddPromotions(list, from, to, false);
+                else list.Add(EncodeMove(from, to));
+            }
+            int twice = to + forward;
+            if (RankOf(from) == startRank && !(occupied & SquareBB(twice)) && restrict(from, SquareBB(twice))) {
+                list.Add(EncodeMove(from, twice, DoublePush));
+            }
+        }
+        for (Bitboard t = restrict(from, PawnAttacks(us, from) & enemies); t; ) {
+            int target = PopLsb(t);
+            if (SquareBB(target) & promotionRank) AddPromotions(list, from, target, true);
+            else list.Add(EncodeMove(from, target, Capture));
+        }
+        // En passant empties two squares at once, so test the resulting occupancy directly
+        if (pos.epSquare != NoSquare && (PawnAttacks(us, from) & SquareBB(pos.epSquare))) {
+            int captured = pos.epSquare ^ 8;
+            Bitboard after = (occupied ^ SquareBB(from) ^ SquareBB(captured)) | SquareBB(pos.epSquare);
+            if (!(pos.AttackersTo(king, after) & enemies & ~SquareBB(captured))) {
+                list.Add(EncodeMove(from, pos.epSquare, EnPassant));
+            }
+        }
+    }
+
+    // Pieces
+    for (Bitboard b = pos.Pieces(us, Knight) & ~pos.pinned; b; ) {
+        int from = PopLsb(b);
+        AddMoves(list, from, KnightAttacks(from) & allowed, enemies);
+    }
+    for (Bitboard b = pos.Pieces(us, Bishop) | pos.Pieces(us, Queen); b; ) {
+        int from = PopLsb(b);
+        AddMoves(list, from, restrict(from, BishopAttacks(from, occupied)), enemies);
+    }
+    for (Bitboard b = pos.Pieces(us, Rook) | pos.Pieces(us, Queen); b; ) {
+        int from = PopLsb(b);
+        AddMoves(list, from, restrict(from, RookAttacks(from, occupied)), enemies);
+    }
+
+    // Castling: the king may not start, pass through or land on an attacked square
+    uint8_t kingSide = us == White ? WhiteKingSide : BlackKingSide;
+    uint8_t queenSide = us == White ? WhiteQueenSide : BlackQueenSide;
+    if ((pos.castling & (kingSide | queenSide)) && !pos.checkers) {
+        int e = king;
+        if ((pos.castling & kingSide) &&
+            !(occupied & (SquareBB(e + 1) | SquareBB(e + 2))) &&
+            !pos.IsSquareAttacked(e + 1, them) && !pos.IsSquareAttacked(e + 2, them)) {
+            list.Add(EncodeMove(e, e + 2, KingCastle));
+        }
+        if ((pos.castling & queenSide) &&
+            !(occupied & (SquareBB(e - 1) | SquareBB(e - 2) | SquareBB(e - 3))) &&
+            !pos.IsSquareAttacked(e - 1, them) && !pos.IsSquareAttacked(e - 2, them)) {
+            list.Add(EncodeMove(e, e - 2, QueenCastle));
+        }
+    }
+}
+
+// Find the legal move from -> to (the first promotion choice if several match)
+inline Move FindMove(const MoveList& list, int from, int to, PieceType promotion = Queen) {
+    for (Move m : list) {
+        if (MoveFrom(m) != from || MoveTo(m) != to) continue;
+        if (IsPromotion(m) && PromotionType(m) != promotion) continue;
+        return m;
+    }
+    return NullMove;
+}
+
+// Legal move given in UCI notation ("e2e4", "e7e8q"), or NullMove
+inline Move ParseUciMove(const Position& pos, const std::string& text) {
+    MoveList moves;
+    GenerateMoves(pos, moves);
+    for (Move m : moves) {
+        if (MoveToUci(m) == text) return m;
+    }
+    return NullMove;
+}
@@ -0,0 +1,416 @@
+#pragma once
+#include <immintrin.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+#include "mmap.h"
+#include "movegen.h"
+
+// Efficiently updatable neural network evaluation (NNUE), HalfKP style.
+//
+// Each perspective sees every non-king piece relative to its own king square:
+// 64 king squares x 10 piece kinds x 64 squares = 40960 binary inputs, of which
+// about 30 are active. The first layer is a sum of weight columns, so it is kept
+// in an int16 accumulator and updated by adding and subtracting the few columns a
+// move changes. Only a king move of that perspective forces a full refresh.
+// The two accumulators (side to move first) are clipped to [0, 127] and go through
+// an int8 hidden layer and an int8 output neuron. A per-feature int32 PSQT term is
+// added to the output, so a net can carry material directly.
+
+const int NnueInputs = 64 * 640;
+const int NnueL1 = 64;         // Accumulator width per perspective
+const int NnueL2 = 16;         // Hidden layer width
+const int NnueHiddenShift = 6; // Hidden layer sums are scaled down by 2^6 before clipping
+const int NnueOutputScale = 16; // Output units per centipawn
+
+struct alignas(64) NnueAccumulator {
+    int16_t values[2][NnueL1]; // Indexed by perspective
+    int32_t psqt[2];
+};
+
+// Input index of piece p on sq as seen by `perspective` whose king stands on kingSq.
+// Black sees the board flipped, so a net is colour-symmetric by construction.
+inline int NnueFeature(Side perspective, int kingSq, Piece p, int sq) {
+    if (perspective == Black) {
+        kingSq ^= 56;
+        sq ^= 56;
+    }
+    int kind = TypeOf(p) * 2 + (SideOf(p) != perspective);
+    return kingSq * 640 + kind * 64 + sq;
+}
+
+// Layers past the accumulator, pointing into the loaded network
+struct NnueLayers {
+    const int32_t* hiddenBias;    // [NnueL2]
+    const int8_t* hiddenWeights;  // [NnueL2][2 * NnueL1]
+    int32_t outputBias;
+    const int8_t* outputWeights;  // [NnueL2]
+};
+
+// One implementation of the two hot loops per instruction set
+struct NnueKernels {
+    const char* name;
+    bool (*supported)();
+    // out = base + sum(add columns) - sum(sub columns), NnueL1 lanes
+    void (*accumulate)(int16_t* out, const int16_t* base, const int16_t* const* add, int addCount,
+                       const int16_t* const* sub, int subCount);
+    // Output of the layers after the accumulator, before scaling
+    int32_t (*propagate)(const int16_t* us, const int16_t* them, const NnueLayers& layers);
+};
+
+inline uint8_t NnueClip(int v) { return uint8_t(v < 0 ? 0 : v > 127 ? 127 : v); }
+
+inline void NnueAccumulateScalar(int16_t* out, const int16_t* base, const int16_t* const* add, int addCount,
+                                 const int16_t* const* sub, int subCount) {
+    for (int i = 0; i < NnueL1; i++) {
+        int v = base[i];
+        for (int a = 0; a < addCount; a++) v += add[a][i];
+        for (int s = 0; s < subCount; s++) v -= sub[s][i];
+        out[i] = int16_t(v);
+    }
+}
+
+inline int32_t NnuePropagateScalar(const int16_t* us, const int16_t* them, const NnueLayers& layers) {
+    uint8_t input[2 * NnueL1];
+    for (int i = 0; i < NnueL1; i++) {
+        input[i] = NnueClip(us[i]);
+        input[NnueL1 + i] = NnueClip(them[i]);
+    }
+    int32_t output = layers.outputBias;
+    for (int j = 0; j < NnueL2; j++) {
+        const int8_t* w = layers.hiddenWeights + j * 2 * NnueL1;
+        int32_t sum = layers.hiddenBias[j];
+        for (int i = 0; i < 2 * NnueL1; i++) sum += input[i] * w[i];
+        output += NnueClip(sum >> NnueHiddenShift) * layers.outputWeights[j];
+    }
+    return output;
+}
+
+__attribute__((target("sse4.1"))) inline void NnueAccumulateSse41(
+    int16_t* out, const int16_t* base, const int16_t* const* add, int addCount,
+    const int16_t* const* sub, int subCount) {
+    for (int i = 0; i < NnueL1; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(base + i));
+        for (int a = 0; a < addCount; a++) v = _mm_add_epi16(v, _mm_loadu_si128((const __m128i*)(add[a] + i)));
+        for (int s = 0; s < subCount; s++) v = _mm_sub_epi16(v, _mm_loadu_si128((const __m128i*)(sub[s] + i)));
+        _mm_storeu_si128((__m128i*)(out + i), v);
+    }
+}
+
+__attribute__((target("sse4.1"))) inline int32_t NnuePropagateSse41(
+    const int16_t* us, const int16_t* them, const NnueLayers& layers) {
+    alignas(16) uint8_t input[2 * NnueL1];
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    for (int half = 0; half < 2; half++) {
+        const int16_t* acc = half ? them : us;
+        for (int i = 0; i < NnueL1; i += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(acc + i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(acc + i + 8));
+            // packus saturates to [0, 255]; the max/min pair clips to [0, 127] first
+            a = _mm_min_epi16(_mm_max_epi16(a, zero), _mm_set1_epi16(127));
+            b = _mm_min_epi16(_mm_max_epi16(b, zero), _mm_set1_epi16(127));
+            _mm_store_si128((__m128i*)(input + half * NnueL1 + i), _mm_packus_epi16(a, b));
+        }
+    }
+    int32_t output = layers.outputBias;
+    for (int j = 0; j < NnueL2; j++) {
+        const int8_t* w = layers.hiddenWeights + j * 2 * NnueL1;
+        __m128i sum = _mm_setzero_si128();
+        for (int i = 0; i < 2 * NnueL1; i += 16) {
+            __m128i x = _mm_load_si128((const __m128i*)(input + i));
+            __m128i y = _mm_loadu_si128((const __m128i*)(w + i));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_maddubs_epi16(x, y), ones));
+        }
+        sum = _mm_hadd_epi32(sum, sum);
+        sum = _mm_hadd_epi32(sum, sum);
+        int32_t hidden = layers.hiddenBias[j] + _mm_cvtsi128_si32(sum);
+        output += NnueClip(hidden >> NnueHiddenShift) * layers.outputWeights[j];
+    }
+    return output;
+}
+
+__attribute__((target("avx2"))) inline void NnueAccumulateAvx2(
+    int16_t* out, const int16_t* base, const int16_t* const* add, int addCount,
+    const int16_t* const* sub, int subCount) {
+    for (int i = 0; i < NnueL1; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(base + i));
+        for (int a = 0; a < addCount; a++) v = _mm256_add_epi16(v, _mm256_loadu_si256((const __m256i*)(add[a] + i)));
+        for (int s = 0; s < subCount; s++) v = _mm256_sub_epi16(v, _mm256_loadu_si256((const __m256i*)(sub[s] + i)));
+        _mm256_storeu_si256((__m256i*)(out + i), v);
+    }
+}
+
+__attribute__((target("avx2"))) inline int32_t NnuePropagateAvx2(
+    const int16_t* us, const int16_t* them, const NnueLayers& layers) {
+    alignas(32) uint8_t input[2 * NnueL1];
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+    for (int half = 0; half < 2; half++) {
+        const int16_t* acc = half ? them : us;
+        for (int i = 0; i < NnueL1; i += 32) {
+            __m256i a = _mm256_loadu_si256((const __m256i*)(acc + i));
+            __m256i b = _mm256_loadu_si256((const __m256i*)(acc + i + 16));
+            a = _mm256_min_epi16(_mm256_max_epi16(a, zero), _mm256_set1_epi16(127));
+            b = _mm256_min_epi16(_mm256_max_epi16(b, zero), _mm256_set1_epi16(127));
+            // packus works per 128-bit lane; the permute restores element order
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+            _mm256_store_si256((__m256i*)(input + half * NnueL1 + i), packed);
+        }
+    }
+    int32_t output = layers.outputBias;
+    for (int j = 0; j < NnueL2; j++) {
+        const int8_t* w = layers.hiddenWeights + j * 2 * NnueL1;
+        __m256i sum = _mm256_setzero_si256();
+        for (int i = 0; i < 2 * NnueL1; i += 32) {
+            __m256i x = _mm256_load_si256((const __m256i*)(input + i));
+            __m256i y = _mm256_loadu_si256((const __m256i*)(w + i));
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(x, y), ones));
+        }
+        __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        s = _mm_hadd_epi32(s, s);
+        s = _mm_hadd_epi32(s, s);
+        int32_t hidden = layers.hiddenBias[j] + _mm_cvtsi128_si32(s);
+        output += NnueClip(hidden >> NnueHiddenShift) * layers.outputWeights[j];
+    }
+    return output;
+}
+
+inline bool NnueHasAvx2() { return __builtin_cpu_supports("avx2"); }
+inline bool NnueHasSse41() { return __builtin_cpu_supports("sse4.1"); }
+inline bool NnueHasScalar() { return true; }
+
+// Fastest first
+const NnueKernels NnueKernelSets[] = {
+    {"avx2", NnueHasAvx2, NnueAccumulateAvx2, NnuePropagateAvx2},
+    {"sse4.1", NnueHasSse41, NnueAccumulateSse41, NnuePropagateSse41},
+    {"scalar", NnueHasScalar, NnueAccumulateScalar, NnuePropagateScalar},
+};
+
+inline const NnueKernels* BestNnueKernels() {
+    __builtin_cpu_init();
+    for (const NnueKernels& kernels : NnueKernelSets) {
+        if (kernels.supported()) return &kernels;
+    }
+    return &NnueKernelSets[2];
+}
+
+// File layout, little-endian, each block following the previous one:
+//   header (64 bytes), int16 ftBias[L1], int16 ftWeights[Inputs][L1], int32 ftPsqt[Inputs],
+//   int32 hiddenBias[L2], int8 hiddenWeights[L2][2*L1], int32 outputBias, int8 outputWeights[L2]
+struct NnueHeader {
+    char magic[8];     // "CHSNNUE1"
+    uint32_t inputs;
+    uint32_t l1;
+    uint32_t l2;
+    uint8_t reserved[44];
+};
+static_assert(sizeof(NnueHeader) == 64, "NNUE header is 64 bytes");
+
+const size_t NnueFileSize = sizeof(NnueHeader) + sizeof(int16_t) * NnueL1 +
+                            sizeof(int16_t) * size_t(NnueInputs) * NnueL1 + sizeof(int32_t) * NnueInputs +
+                            sizeof(int32_t) * NnueL2 + 2 * NnueL1 * NnueL2 + sizeof(int32_t) + NnueL2;
+
+class NnueNetwork {
+public:
+    NnueNetwork() : kernels(BestNnueKernels()) {}
+    NnueNetwork(const NnueNetwork&) = delete;
+    NnueNetwork& operator=(const NnueNetwork&) = delete;
+
+    // Map a network file read-only; the weights are used in place, never copied. The
+    // file is checked before it replaces anything, so a failed load leaves the current
+    // network in use.
+    bool Load(const char* path) {
+        MappedFile candidate;
+        if (!candidate.Open(path, MADV_WILLNEED)) return false;
+        if (!Bind(reinterpret_cast<const uint8_t*>(candidate.Data()), candidate.Size())) return false;
+        file.Swap(candidate);  // The old mapping is released with candidate
+        owned.clear();
+        return true;
+    }
+
+    // A small deterministic net for tests and for running without a file: PSQT columns
+    // carry the middlegame material and piece-square values, the layers add a little
+    // pseudo-random texture so every SIMD path has real work to agree on
+    void LoadBuiltin() {
+        file.Close();
+        owned.assign(NnueFileSize, 0);
+        uint8_t* p = owned.data();
+        NnueHeader header = {};
+        memcpy(header.magic, "CHSNNUE1", 8);
+        header.inputs = NnueInputs;
+        header.l1 = NnueL1;
+        header.l2 = NnueL2;
+        memcpy(p, &header, sizeof(header));
+        p += sizeof(header);
+
+        uint64_t seed = 0x4E4E55454E4E5545ULL;
+        auto small = [&](int range) { return int(SplitMix64(seed) % uint64_t(2 * range + 1)) - range; };
+        int16_t* ftBias = reinterpret_cast<int16_t*>(p);
+        for (int i = 0; i < NnueL1; i++) ftBias[i] = int16_t(16 + small(8));
+        p += sizeof(int16_t) * NnueL1;
+        int16_t* ftWeights = reinterpret_cast<int16_t*>(p);
+        for (size_t i = 0; i < size_t(NnueInputs) * NnueL1; i++) ftWeights[i] = int16_t(small(4));
+        p += sizeof(int16_t) * size_t(NnueInputs) * NnueL1;
+        int32_t* ftPsqt = reinterpret_cast<int32_t*>(p);
+        for (int f = 0; f < NnueInputs; f++) {
+            int kind = (f % 640) / 64, sq = f % 64;
+            Piece piece = MakePiece(kind & 1 ? Black : White, PieceType(kind / 2));
+            ftPsqt[f] = MgScore(Psqt.score[piece][sq]) * NnueOutputScale;
+        }
+        p += sizeof(int32_t) * NnueInputs;
+        int32_t* hiddenBias = reinterpret_cast<int32_t*>(p);
+        for (int j = 0; j < NnueL2; j++) hiddenBias[j] = small(64);
+        p += sizeof(int32_t) * NnueL2;
+        int8_t* hiddenWeights = reinterpret_cast<int8_t*>(p);
+        for (int i = 0; i < 2 * NnueL1 * NnueL2; i++) hiddenWeights[i] = int8_t(small(8));
+        p += 2 * NnueL1 * NnueL2;
+        int32_t outputBias = 0;
+        memcpy(p, &outputBias, sizeof(outputBias));
+        p += sizeof(int32_t);
+        int8_t* outputWeights = reinterpret_cast<int8_t*>(p);
+        for (int j = 0; j < NnueL2; j++) outputWeights[j] = int8_t(small(2));
+        Bind(owned.data(), owned.size());
+    }
+
+    bool Save(const char* path) const {
+        FILE* out = fopen(path, "wb");
+        if (!out) return false;
+        bool ok = fwrite(data, 1, NnueFileSize, out) == NnueFileSize;
+        return fclose(out) == 0 && ok;
+    }
+
+    bool Loaded() const { return data != nullptr; }
+
+    // Instruction set used for inference; defaults to the best this CPU supports
+    const NnueKernels& Kernels() const { return *kernels; }
+    void SetKernels(const NnueKernels& k) { kernels = &k; }
+
+    // Rebuild one perspective from scratch
+    void Refresh(const Position& pos, Side perspective, NnueAccumulator& acc) const {
+        const int16_t* columns[32];
+        const int16_t* base = ftBias;
+        int count = 0;
+        int32_t psqt = 0;
+        int king = pos.KingSquare(perspective);
+        for (Bitboard b = pos.Occupied() & ~pos.Pieces(King); b; ) {
+            int sq = PopLsb(b);
+            int f = NnueFeature(perspective, king, pos.PieceOn(sq), sq);
+            psqt += ftPsqt[f];
+            if (count == 32) { // More pieces than a legal game can have: add them in batches
+                kernels->accumulate(acc.values[perspective], base, columns, count, nullptr, 0);
+                base = acc.values[perspective];
+                count = 0;
+            }
+            columns[count++] = ftWeights + size_t(f) * NnueL1;
+        }
+        kernels->accumulate(acc.values[perspective], base, columns, count, nullptr, 0);
+        acc.psqt[perspective] = psqt;
+    }
+
+    void Refresh(const Position& pos, NnueAccumulator& acc) const {
+        Refresh(pos, White, acc);
+        Refresh(pos, Black, acc);
+    }
+
+    // next = prev updated for move m, given the position after m and the piece it captured
+    void Update(const Position& after, Move m, Piece captured, const NnueAccumulator& prev,
+                NnueAccumulator& next) const {
+        int from = MoveFrom(m);
+        int to = MoveTo(m);
+        Side us = Opposite(after.sideToMove);
+        Piece placed = after.PieceOn(to);
+        Piece moved = IsPromotion(m) ? MakePiece(us, Pawn) : placed;
+
+        for (Side perspective : {White, Black}) {
+            if (TypeOf(moved) == King && perspective == us) {
+                Refresh(after, perspective, next); // Every feature is relative to this king
+                continue;
+            }
+            int king = after.KingSquare(perspective);
+            const int16_t* add[2];
+            const int16_t* sub[2];
+            int addCount = 0, subCount = 0;
+            int32_t psqt = prev.psqt[perspective];
+            auto added = [&](Piece p, int sq) {
+                int f = NnueFeature(perspective, king, p, sq);
+                add[addCount++] = ftWeights + size_t(f) * NnueL1;
+                psqt += ftPsqt[f];
+            };
+            auto removed = [&](Piece p, int sq) {
+                int f = NnueFeature(perspective, king, p, sq);
+                sub[subCount++] = ftWeights + size_t(f) * NnueL1;
+                psqt -= ftPsqt[f];
+            };
+
+            if (IsCastle(m)) {
+                // Kings are not inputs, only the rook changes for the other side
+                Piece rook = MakePiece(us, Rook);
+                bool kingSide = MoveFlags(m) == KingCastle;
+                removed(rook, kingSide ? to + 1 : to - 2);
+                added(rook, kingSide ? to - 1 : to + 1);
+            } else {
+                if (TypeOf(moved) != King) {
+                    removed(moved, from);
+                    added(placed, to);
+                }
+                if (captured != NoPiece) removed(captured, MoveFlags(m) == EnPassant ? to ^ 8 : to);
+            }
+            kernels->accumulate(next.values[perspective], prev.values[perspective], add, addCount, sub, subCount);
+            next.psqt[perspective] = psqt;
+        }
+    }
+
+    // Centipawns from the side to move's point of view
+    int Evaluate(const NnueAccumulator& acc, Side sideToMove) const {
+        Side them = Opposite(sideToMove);
+        int32_t output = kernels->propagate(acc.values[sideToMove], acc.values[them], layers);
+        return (output + (acc.psqt[sideToMove] - acc.psqt[them]) / 2) / NnueOutputScale;
+    }
+
+    // One-off evaluation of a position, e.g. the GUI's current game state
+    int Evaluate(const Position& pos) const {
+        NnueAccumulator acc;
+        Refresh(pos, acc);
+        return Evaluate(acc, pos.sideToMove);
+    }
+
+private:
+    MappedFile file;
+    std::vector<uint8_t> owned;
+    const uint8_t* data = nullptr;
+    const int16_t* ftBias = nullptr;
+    const int16_t* ftWeights = nullptr;
+    const int32_t* ftPsqt = nullptr;
+    NnueLayers layers = {};
+    const NnueKernels* kernels;
+
+    // Point the weights into p, or return false and leave them as they were
+    bool Bind(const uint8_t* p, size_t size) {
+        NnueHeader header;
+        if (size != NnueFileSize) return false;
+        memcpy(&header, p, sizeof(header));
+        if (memcmp(header.magic, "CHSNNUE1", 8) != 0 || header.inputs != NnueInputs ||
+            header.l1 != NnueL1 || header.l2 != NnueL2) {
+            return false;
+        }
+        data = p;
+        p += sizeof(header);
+        ftBias = reinterpret_cast<const int16_t*>(p);
+        p += sizeof(int16_t) * NnueL1;
+        ftWeights = reinterpret_cast<const int16_t*>(p);
+        p += sizeof(int16_t) * size_t(NnueInputs) * NnueL1;
+        ftPsqt = reinterpret_cast<const int32_t*>(p);
+        p += sizeof(int32_t) * NnueInputs;
+        layers.hiddenBias = reinterpret_cast<const int32_t*>(p);
+        p += sizeof(int32_t) * NnueL2;
+        layers.hiddenWeights = reinterpret_cast<const int8_t*>(p);
+        p += 2 * NnueL1 * NnueL2;
+        memcpy(&layers.outputBias, p, sizeof(int32_t));
+        p += sizeof(int32_t);
+        layers.outputWeights = reinterpret_cast<const int8_t*>(p);
+        return true;
+    }
+};
@@ -0,0 +1,130 @@
+#pragma once
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include "position.h"
+
+// Pawn-structure terms; the king and pieces are not involved, so the result depends
+// only on the pawns and can be cached by Position::pawnKey
+const Score DoubledPawn = MakeScore(-10, -20);
+const Score IsolatedPawn = MakeScore(-10, -15);
+const Score BackwardPawn = MakeScore(-8, -10);
+const Score PawnIsland = MakeScore(-5, -10);   // For each island beyond the first
+const Score PassedPawn[8] = {
+    MakeScore(0, 0), MakeScore(5, 10), MakeScore(10, 20), MakeScore(15, 35),
+    MakeScore(30, 60), MakeScore(50, 100), MakeScore(80, 150), MakeScore(0, 0),
+};
+
+inline Bitboard PawnAttacksAll(Side side, Bitboard pawns) {
+    Bitboard forward = side == White ? ShiftNorth(pawns) : ShiftSouth(pawns);
+    return ShiftEast(forward) | ShiftWest(forward);
+}
+
+// Squares in front of sq from side's point of view, on the same file
+inline Bitboard ForwardFile(Side side, int sq) {
+    Bitboard file = FileA << FileOf(sq);
+    return side == White ? file & (~0ULL << sq << 1) : file & ((1ULL << sq) - 1);
+}
+
+inline Bitboard AdjacentFiles(int sq) {
+    Bitboard file = FileA << FileOf(sq);
+    return ShiftEast(file) | ShiftWest(file);
+}
+
+// Everything the evaluation and the GUI hints want to know about one pawn structure
+struct PawnInfo {
+    Key key;
+    Score score;           // White minus black
+    Bitboard passed[2];
+    Bitboard doubled[2];   // Pawns with an own pawn further up the same file
+    Bitboard isolated[2];
+    Bitboard backward[2];  // Cannot be supported by a pawn and cannot advance safely
+    uint8_t islands[2];    // Groups of adjacent files holding own pawns
+};
+
+inline void AnalyzePawns(const Position& pos, PawnInfo& info) {
+    info.key = pos.pawnKey;
+    info.score = 0;
+    for (Side side : {White, Black}) {
+        Side them = Opposite(side);
+        Bitboard ours = pos.Pieces(side, Pawn);
+        Bitboard theirs = pos.Pieces(them, Pawn);
+        Bitboard theirAttacks = PawnAttacksAll(them, theirs);
+        Bitboard passed = 0, doubled = 0, isolated = 0, backward = 0;
+        Score score = 0;
+
+        for (Bitboard b = ours; b; ) {
+            int sq = PopLsb(b);
+            Bitboard front = ForwardFile(side, sq);
+            Bitboard neighbours = AdjacentFiles(sq) & ours;
+            if (front & ours) {
+                doubled |= SquareBB(sq);
+                score += DoubledPawn;
+            }
+            if (!neighbours) {
+                isolated |= SquareBB(sq);
+                score += IsolatedPawn;
+            } else {
+                // No neighbour level with or behind it, and the stop square is covered by an enemy pawn
+                Bitboard behind = ForwardFile(them, sq) | SquareBB(sq);
+                Bitboard supportSpan = ShiftEast(behind) | ShiftWest(behind);
+                int stop = side == White ? sq + 8 : sq - 8;
+                if (!(supportSpan & ours) && stop >= 0 && stop < 64 && (SquareBB(stop) & theirAttacks)) {
+                    backward |= SquareBB(sq);
+                    score += BackwardPawn;
+                }
+            }
+            Bitboard span = front | ShiftEast(front) | ShiftWest(front);
+            if (!(span & theirs) && !(front & ours)) {
+                passed |= SquareBB(sq);
+                score += PassedPawn[side == White ? RankOf(sq) : 7 - RankOf(sq)];
+            }
+        }
+
+        unsigned files = 0;
+        for (Bitboard b = ours; b; ) files |= 1u << FileOf(PopLsb(b));
+        int islands = PopCount(files & ~(files << 1));
+        if (islands > 1) score += PawnIsland * (islands - 1);
+
+        info.passed[side] = passed;
+        info.doubled[side] = doubled;
+        info.isolated[side] = isolated;
+        info.backward[side] = backward;
+        info.islands[side] = uint8_t(islands);
+        info.score += side == White ? score : -score;
+    }
+}
+
+// Per-thread cache of pawn-structure results indexed by the pawn key. Pawns move
+// rarely, so almost every lookup during search finds the structure already analysed.
+// Not shared between threads: no atomics, and the counters are plain integers.
+class PawnTable {
+public:
+    explicit PawnTable(size_t entries = 1 << 14) : table(new PawnInfo[entries]), mask(entries - 1) { Clear(); }
+
+    void Clear() {
+        for (size_t i = 0; i <= mask; i++) table[i] = PawnInfo{};
+        table[0].key = 1; // Entry 0 would otherwise match the empty pawn key unanalysed
+        hits = misses = 0;
+    }
+
+    const PawnInfo& Probe(const Position& pos) {
+        PawnInfo& entry = table[pos.pawnKey & mask];
+        if (entry.key == pos.pawnKey) {
+            hits++;
+        } else {
+            misses++;
+            AnalyzePawns(pos, entry);
+        }
+        return entry;
+    }
+
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    double HitRate() const { return hits + misses ? double(hits) / double(hits + misses) : 0.0; }
+
+private:
+    std::unique_ptr<PawnInfo[]> table;
+    size_t mask;
+};
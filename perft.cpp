@@ -0,0 +1,156 @@
+// Headless move-generation counter and regression benchmark.
+// Build: g++ -O2 -std=c++17 perft.cpp -o perft
+//
+//   perft <depth> [fen]          divide: nodes below each root move, total and nodes/sec
+//   perft --suite [--min-nps N]  run the published positions, Polyglot example keys and
+//                                a PGN write/read round trip; exit code 1 on any mismatch
+//                                or when throughput falls below N nodes/sec
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "fen.h"
+#include "movegen.h"
+#include "pgn.h"
+#include "polyglot.h"
+
+uint64_t Perft(Position& pos, int depth) {
+    MoveList moves;
+    GenerateMoves(pos, moves);
+    if (depth <= 1) return depth == 1 ? moves.Size() : 1; // Bulk-count the last ply
+
+    uint64_t nodes = 0;
+    for (Move m : moves) {
+        UndoInfo undo;
+        MakeMove(pos, m, undo);
+        nodes += Perft(pos, depth - 1);
+        UnmakeMove(pos, m, undo);
+    }
+    return nodes;
+}
+
+double SecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct PerftCase {
+    const char* name;
+    const char* fen;
+    uint64_t expected[6]; // Node counts for depth 1.., 0 terminates
+};
+
+// Reference counts from the Chess Programming Wiki "Perft Results" page
+const PerftCase Suite[] = {
+    {"start", StartFen,
+     {20, 400, 8902, 197281, 4865609, 0}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+     {48, 2039, 97862, 4085603, 0}},
+    {"en-passant", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+     {14, 191, 2812, 43238, 674624, 0}},
+    {"promotion", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+     {6, 264, 9467, 422333, 0}},
+    {"promotion-mirrored", "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1",
+     {6, 264, 9467, 422333, 0}},
+    {"talkchess", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+     {44, 1486, 62379, 2103487, 0}},
+    {"middlegame", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+     {46, 2079, 89890, 3894594, 0}},
+};
+
+int RunSuite(double minNps) {
+    uint64_t totalNodes = 0;
+    int failures = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (const PerftCase& test : Suite) {
+        Position pos;
+        if (!ParseFen(test.fen, pos)) {
+            printf("%-20s bad FEN\n", test.name);
+            failures++;
+            continue;
+        }
+        for (int depth = 1; depth <= 6 && test.expected[depth - 1]; depth++) {
+            uint64_t nodes = Perft(pos, depth);
+            totalNodes += nodes;
+            bool ok = nodes == test.expected[depth - 1];
+            if (!ok) failures++;
+            printf("%-20s depth %d  %12llu  %s\n", test.name, depth,
+                   (unsigned long long)nodes, ok ? "ok" : "FAIL");
+            if (!ok) printf("%-20s          expected %llu\n", "",
+                            (unsigned long long)test.expected[depth - 1]);
+        }
+    }
+
+    double seconds = SecondsSince(start);
+    bool keysOk = CheckPolyglotKeys();
+    if (!keysOk) failures++;
+    printf("%-20s %zu keys             %s\n", "polyglot", sizeof(PolyglotKeyCases) / sizeof(PolyglotKeyCases[0]),
+           keysOk ? "ok" : "FAIL");
+    bool pgnOk = CheckPgnRoundTrip();
+    if (!pgnOk) failures++;
+    printf("%-20s %zu games            %s\n", "pgn round trip", sizeof(PgnRoundTripFens) / sizeof(PgnRoundTripFens[0]),
+           pgnOk ? "ok" : "FAIL");
+    double nps = totalNodes / (seconds > 0 ? seconds : 1e-9);
+    printf("\nNodes: %llu  Time: %.3fs  NPS: %.0f\n", (unsigned long long)totalNodes, seconds, nps);
+
+    if (failures) {
+        printf("%d mismatches\n", failures);
+        return 1;
+    }
+    if (minNps > 0 && nps < minNps) {
+        printf("Throughput below %.0f nodes/sec\n", minNps);
+        return 1;
+    }
+    return 0;
+}
+
+int RunDivide(int depth, const std::string& fen) {
+    Position pos;
+    if (!ParseFen(fen, pos)) {
+        fprintf(stderr, "Invalid FEN: %s\n", fen.c_str());
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    MoveList moves;
+    GenerateMoves(pos, moves);
+    uint64_t total = 0;
+    for (Move m : moves) {
+        UndoInfo undo;
+        MakeMove(pos, m, undo);
+        uint64_t nodes = Perft(pos, depth - 1);
+        UnmakeMove(pos, m, undo);
+        total += nodes;
+        printf("%s: %llu\n", MoveToUci(m).c_str(), (unsigned long long)nodes);
+    }
+    double seconds = SecondsSince(start);
+
+    printf("\nMoves: %d\nNodes: %llu\nTime: %.3fs\nNPS: %.0f\n", moves.Size(),
+           (unsigned long long)total, seconds, total / (seconds > 0 ? seconds : 1e-9));
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && std::string(argv[1]) == "--suite") {
+        double minNps = 0;
+        for (int i = 2; i + 1 < argc; i++) {
+            if (std::string(argv[i]) == "--min-nps") minNps = atof(argv[i + 1]);
+        }
+        return RunSuite(minNps);
+    }
+
+    if (argc < 2 || atoi(argv[1]) < 1) {
+        fprintf(stderr, "Usage: %s <depth> [fen]\n       %s --suite [--min-nps N]\n", argv[0], argv[0]);
+        return 2;
+    }
+
+    std::string fen = StartFen;
+    if (argc >= 3) {
+        fen.clear();
+        for (int i = 2; i < argc; i++) {
+            if (i > 2) fen += ' ';
+            fen += argv[i]; // Accept an unquoted FEN split across arguments
+        }
+    }
+    return RunDivide(atoi(argv[1]), fen);
+}
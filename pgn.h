@@ -0,0 +1,381 @@
+#pragma once
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "fen.h"
+#include "game.h"
+#include "mmap.h"
+
+// Standard algebraic notation (SAN) of a legal move, e.g. "Nbd7", "exd6", "e8=Q+", "O-O-O#"
+inline std::string MoveToSan(const Position& pos, Move m) {
+    int from = MoveFrom(m);
+    int to = MoveTo(m);
+    std::string san;
+    if (MoveFlags(m) == KingCastle) {
+        san = "O-O";
+    } else if (MoveFlags(m) == QueenCastle) {
+        san = "O-O-O";
+    } else {
+        PieceType type = TypeOf(pos.PieceOn(from));
+        if (type == Pawn) {
+            if (IsCapture(m)) san += char('a' + FileOf(from));
+        } else {
+            san += "PNBRQK"[type];
+            // Disambiguate against other pieces of the same type that can reach `to`
+            MoveList legal;
+            GenerateMoves(pos, legal);
+            bool ambiguous = false, sameFile = false, sameRank = false;
+            for (Move other : legal) {
+                int otherFrom = MoveFrom(other);
+                if (other == m || MoveTo(other) != to || otherFrom == from) continue;
+                if (TypeOf(pos.PieceOn(otherFrom)) != type) continue;
+                ambiguous = true;
+                sameFile |= FileOf(otherFrom) == FileOf(from);
+                sameRank |= RankOf(otherFrom) == RankOf(from);
+            }
+            if (ambiguous && (!sameFile || sameRank)) san += char('a' + FileOf(from));
+            if (ambiguous && sameFile) san += char('1' + RankOf(from));
+        }
+        if (IsCapture(m)) san += 'x';
+        san += char('a' + FileOf(to));
+        san += char('1' + RankOf(to));
+        if (IsPromotion(m)) {
+            san += '=';
+            san += "PNBRQK"[PromotionType(m)];
+        }
+    }
+
+    Position after = pos;
+    UndoInfo undo;
+    MakeMove(after, m, undo);
+    if (after.checkers) {
+        MoveList replies;
+        GenerateMoves(after, replies);
+        san += replies.Size() ? '+' : '#';
+    }
+    return san;
+}
+
+// The legal move in `legal` written as san, or NullMove if none or more than one match.
+// Accepts the usual sloppiness: missing or extra check marks, annotations, "0-0", "e8Q".
+inline Move ParseSan(const Position& pos, std::string_view san, const MoveList& legal) {
+    while (!san.empty() && san.back() != '\0' && strchr("+#!?", san.back())) san.remove_suffix(1);
+    if (san.size() < 2) return NullMove;
+
+    if (san[0] == 'O' || san[0] == '0') {
+        int flag = san.size() >= 5 ? QueenCastle : KingCastle; // "O-O-O" / "O-O"
+        for (Move m : legal) {
+            if (MoveFlags(m) == flag) return m;
+        }
+        return NullMove;
+    }
+
+    PieceType type = Pawn;
+    // strchr also finds the terminator, so a NUL byte must not reach it
+    if (const char* p = san[0] != '\0' ? strchr("NBRQK", san[0]) : nullptr) {
+        type = PieceType(Knight + (p - "NBRQK"));
+        san.remove_prefix(1);
+    }
+    PieceType promotion = PieceTypeCount;
+    if (type == Pawn && san.size() >= 3 && san.back() != '\0' && strchr("NBRQ", san.back())) {
+        promotion = PieceType(Knight + (strchr("NBRQ", san.back()) - "NBRQ"));
+        san.remove_suffix(1);
+        if (san.back() == '=') san.remove_suffix(1);
+    }
+    if (san.size() < 2) return NullMove;
+    char toFile = san[san.size() - 2], toRank = san[san.size() - 1];
+    if (toFile < 'a' || toFile > 'h' || toRank < '1' || toRank > '8') return NullMove;
+    int to = MakeSquare(toFile - 'a', toRank - '1');
+
+    // Whatever is left before the destination is a file and/or rank hint (and maybe an 'x')
+    int fromFile = -1, fromRank = -1;
+    for (char c : san.substr(0, san.size() - 2)) {
+        if (c >= 'a' && c <= 'h') fromFile = c - 'a';
+        else if (c >= '1' && c <= '8') fromRank = c - '1';
+        else if (c != 'x' && c != '-' && c != ':') return NullMove;
+    }
+
+    Bitboard candidates = pos.Pieces(pos.sideToMove, type);
+    Move found = NullMove;
+    for (Move m : legal) {
+        int from = MoveFrom(m);
+        if (MoveTo(m) != to || !(candidates & SquareBB(from))) continue;
+        if (fromFile >= 0 && FileOf(from) != fromFile) continue;
+        if (fromRank >= 0 && RankOf(from) != fromRank) continue;
+        if (IsPromotion(m) ? PromotionType(m) != promotion : promotion != PieceTypeCount) continue;
+        if (found != NullMove) return NullMove; // Ambiguous
+        found = m;
+    }
+    return found;
+}
+
+inline Move ParseSan(const Position& pos, std::string_view san) {
+    MoveList legal;
+    GenerateMoves(pos, legal);
+    return ParseSan(pos, san, legal);
+}
+
+// A tag pair such as [White "Carlsen"]. Views point into the parsed text; escapes are left as written.
+struct PgnTag {
+    std::string_view name;
+    std::string_view value;
+};
+
+// One game read from PGN. Reused across Next() calls so its vectors keep their capacity.
+struct PgnGame {
+    std::vector<PgnTag> tags;
+    Game game;                // Start position, moves and final position as replayed
+    std::string_view result;  // "1-0", "0-1", "1/2-1/2" or "*" (empty if the movetext had none)
+    std::string error;        // Empty unless a move or the FEN tag could not be replayed
+    size_t offset = 0;        // Byte offset of the game in the input
+
+    std::string_view Tag(std::string_view name) const {
+        for (const PgnTag& tag : tags) {
+            if (tag.name == name) return tag.value;
+        }
+        return {};
+    }
+};
+
+inline bool IsPgnResult(std::string_view token) {
+    return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+}
+
+// Splits PGN text into games and replays each one through the move generator.
+// Works on any contiguous buffer; the text must outlive the views in PgnGame.
+class PgnParser {
+public:
+    PgnParser(const char* begin, const char* end) : text(begin), cur(begin), end(end) {}
+
+    size_t Offset() const { return size_t(cur - text); }
+
+    // Read the next game; false once the input is exhausted
+    bool Next(PgnGame& out) {
+        out.tags.clear();
+        out.result = {};
+        out.error.clear();
+
+        // Skip anything before the tag section or movetext of the next game
+        while (cur < end) {
+            SkipWhitespace();
+            if (cur < end && (*cur == '%' || *cur == ';')) SkipLine();
+            else break;
+        }
+        if (cur >= end) return false;
+        out.offset = Offset();
+
+        while (cur < end && *cur == '[') {
+            ReadTag(out);
+            SkipWhitespace();
+        }
+
+        Position start;
+        std::string_view fen = out.Tag("FEN");
+        if (fen.empty()) {
+            start.SetStartPosition();
+        } else if (!ParseFen(std::string(fen), start)) {
+            out.error = "invalid FEN tag";
+            start.SetStartPosition();
+        }
+        out.game.Reset(start);
+        ReadMovetext(out);
+        return true;
+    }
+
+private:
+    const char* text;
+    const char* cur;
+    const char* end;
+
+    static bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+    bool AtLineStart() const { return cur == text || cur[-1] == '\n'; }
+
+    void SkipWhitespace() {
+        while (cur < end && IsSpace(*cur)) cur++;
+    }
+
+    void SkipLine() {
+        const char* nl = static_cast<const char*>(memchr(cur, '\n', size_t(end - cur)));
+        cur = nl ? nl + 1 : end;
+    }
+
+    void SkipPast(char c) {
+        const char* found = static_cast<const char*>(memchr(cur, c, size_t(end - cur)));
+        cur = found ? found + 1 : end;
+    }
+
+    // [Name "Value"]
+    void ReadTag(PgnGame& out) {
+        cur++;
+        const char* nameStart = cur;
+        while (cur < end && !IsSpace(*cur) && *cur != '"' && *cur != ']') cur++;
+        std::string_view name(nameStart, size_t(cur - nameStart));
+        while (cur < end && *cur != '"' && *cur != ']' && *cur != '\n') cur++;
+        std::string_view value;
+        if (cur < end && *cur == '"') {
+            const char* valueStart = ++cur;
+            while (cur < end && *cur != '"') cur += (*cur == '\\' && cur + 1 < end) ? 2 : 1;
+            value = std::string_view(valueStart, size_t(cur - valueStart));
+        }
+        SkipPast(']');
+        if (!name.empty()) out.tags.push_back({name, value});
+    }
+
+    // (variations), which may nest and contain comments
+    void SkipVariation() {
+        int depth = 0;
+        while (cur < end) {
+            char c = *cur++;
+            if (c == '(') depth++;
+            else if (c == ')' && --depth == 0) return;
+            else if (c == '{') SkipPast('}');
+        }
+    }
+
+    void ReadMovetext(PgnGame& out) {
+        MoveList legal;
+        GenerateMoves(out.game.pos, legal);
+        while (cur < end) {
+            SkipWhitespace();
+            if (cur >= end) return;
+            char c = *cur;
+            if (c == '[' && AtLineStart()) return; // Next game's tags: this one had no result
+            if (c == '{') { SkipPast('}'); continue; }
+            if (c == ';' || (c == '%' && AtLineStart())) { SkipLine(); continue; }
+            if (c == '(') { SkipVariation(); continue; }
+            if (c == ')' || c == '}' || c == '[' || c == ']') { cur++; continue; }
+
+            const char* tokenStart = cur;
+            while (cur < end && !IsSpace(*cur) && !memchr("{}();[]\0", *cur, 8)) cur++;
+            if (cur == tokenStart) { cur++; continue; } // A stray NUL byte
+            std::string_view token(tokenStart, size_t(cur - tokenStart));
+
+            if (IsPgnResult(token)) {
+                out.result = token;
+                return;
+            }
+            if (token[0] == '$') continue; // Numeric annotation glyph
+
+            // Move numbers, possibly glued to the move: "12." "12..." "12.Nf3"
+            size_t i = 0;
+            while (i < token.size() && token[i] >= '0' && token[i] <= '9') i++;
+            if (i > 0) {
+                if (i == token.size() || token[i] != '.') {
+                    if (out.error.empty()) out.error = "unexpected token '" + std::string(token) + "'";
+                    continue;
+                }
+                while (i < token.size() && token[i] == '.') i++;
+                token.remove_prefix(i);
+                if (token.empty()) continue;
+            }
+
+            if (!out.error.empty()) continue; // Keep scanning to the result, but stop replaying
+            Move m = ParseSan(out.game.pos, token, legal);
+            if (m == NullMove) {
+                out.error = "ply " + std::to_string(out.game.moves.size() + 1) +
+                            ": illegal or ambiguous move '" + std::string(token) + "'";
+                continue;
+            }
+            out.game.Play(m);
+            legal.Clear();
+            GenerateMoves(out.game.pos, legal);
+        }
+    }
+};
+
+// Streams the games of a PGN file one at a time
+class PgnReader {
+public:
+    bool Open(const char* path) {
+        if (!file.Open(path)) return false;
+        parser = PgnParser(file.Data(), file.Data() + file.Size());
+        return true;
+    }
+
+    bool Next(PgnGame& out) { return parser.Next(out); }
+
+private:
+    MappedFile file;
+    PgnParser parser{nullptr, nullptr};
+};
+
+// Append a game in export format: tags, then SAN movetext wrapped at 80 columns.
+// A SetUp/FEN pair is added when the game did not start from the initial position.
+inline void WritePgn(std::string& out, const std::vector<PgnTag>& tags, const Game& game,
+                     std::string_view result) {
+    // The key ignores the move clocks, which the FEN must carry as well
+    bool fromFen = WriteFen(game.start) != StartFen;
+    for (const PgnTag& tag : tags) {
+        if (fromFen && (tag.name == "SetUp" || tag.name == "FEN")) continue;
+        out += '[';
+        out += tag.name;
+        out += " \"";
+        out += tag.value;
+        out += "\"]\n";
+    }
+    if (fromFen) out += "[SetUp \"1\"]\n[FEN \"" + WriteFen(game.start) + "\"]\n";
+    out += '\n';
+
+    size_t lineStart = out.size();
+    auto append = [&](const std::string& token) {
+        if (out.size() > lineStart && out.size() - lineStart + 1 + token.size() > 80) {
+            out += '\n';
+            lineStart = out.size();
+        } else if (out.size() > lineStart) {
+            out += ' ';
+        }
+        out += token;
+    };
+
+    Position pos = game.start;
+    for (size_t i = 0; i < game.moves.size(); i++) {
+        if (pos.sideToMove == White) append(std::to_string(pos.fullMoveNumber) + ".");
+        else if (i == 0) append(std::to_string(pos.fullMoveNumber) + "...");
+        Move m = game.moves[i];
+        append(MoveToSan(pos, m));
+        UndoInfo undo;
+        MakeMove(pos, m, undo);
+    }
+    append(std::string(result.empty() ? "*" : result));
+    out += "\n\n";
+}
+
+// Start positions that WritePgn must carry through PgnParser unchanged, clocks included
+const char* const PgnRoundTripFens[] = {
+    StartFen,
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 90 40",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 b - - 12 57",
+};
+
+// Writes a short game from each start position and reads it back
+inline bool CheckPgnRoundTrip() {
+    for (const char* fen : PgnRoundTripFens) {
+        Position start;
+        if (!ParseFen(fen, start)) return false;
+        Game game;
+        game.Reset(start);
+        for (int ply = 0; ply < 4; ply++) {
+            MoveList legal;
+            GenerateMoves(game.pos, legal);
+            if (legal.Size() == 0) break;
+            game.Play(legal[0]);
+        }
+        std::string text;
+        WritePgn(text, {}, game, "*");
+
+        PgnParser parser(text.data(), text.data() + text.size());
+        PgnGame read;
+        bool ok = parser.Next(read) && read.error.empty() && read.game.moves == game.moves &&
+                  WriteFen(read.game.start) == WriteFen(game.start) &&
+                  WriteFen(read.game.pos) == WriteFen(game.pos);
+        if (!ok) {
+            fprintf(stderr, "PGN round trip changed the game from %s\n", fen);
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "game.h"
+
+// Win/draw/loss estimate of a position from random playouts, refined in the background.
+// Each worker copies the root into its own scratch Position and plays lightly guided
+// random games to the end: a capture or promotion is preferred half the time, other
+// moves are uniform. A game ends by the same rules the GUI applies (mate, stalemate,
+// insufficient material, the 50-move rule) or as a draw after PlayoutMaxPlies. The
+// inner loop touches only the scratch position and a MoveList on the stack, so a
+// playout allocates nothing. Results are added to the shared totals in batches; a new
+// root bumps the generation and batches of the old one are dropped.
+
+const int PlayoutMaxPlies = 300;
+const int PlayoutBatch = 16;
+
+struct PlayoutStats {
+    uint64_t whiteWins = 0, draws = 0, blackWins = 0;
+    double playoutsPerSec = 0;
+
+    uint64_t Total() const { return whiteWins + draws + blackWins; }
+};
+
+// Result of one playout from pos, from white's point of view: 1, 0 or -1
+inline int Playout(Position& pos, uint64_t& random) {
+    for (int ply = 0; ply < PlayoutMaxPlies; ply++) {
+        MoveList moves;
+        GenerateMoves(pos, moves);
+        if (IsCheckmate(pos, moves)) return pos.sideToMove == White ? -1 : 1;
+        if (IsStalemate(pos, moves) || IsInsufficientMaterial(pos) || pos.halfMoveClock >= 100) return 0;
+
+        uint64_t r = SplitMix64(random);
+        Move m = moves[int(r % uint64_t(moves.Size()))];
+        if (r >> 63) {
+            // Captures and promotions moved to the front, then one of them picked
+            int tactical = 0;
+            for (int i = 0; i < moves.count; i++) {
+                if (IsCapture(moves[i]) || IsPromotion(moves[i])) std::swap(moves.moves[tactical++], moves.moves[i]);
+            }
+            if (tactical) m = moves[int((r >> 32) % uint64_t(tactical))];
+        }
+        UndoInfo undo;
+        MakeMove(pos, m, undo);
+    }
+    return 0;
+}
+
+class PlayoutPool {
+public:
+    // `limit` playouts per position, after which the workers sleep until the next one
+    explicit PlayoutPool(int threads, uint64_t limit = 200000) : limit(limit) {
+        for (int i = 0; i < (threads > 0 ? threads : 1); i++) workers.emplace_back([this, i] { Work(i); });
+    }
+
+    ~PlayoutPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    PlayoutPool(const PlayoutPool&) = delete;
+    PlayoutPool& operator=(const PlayoutPool&) = delete;
+
+    // Estimate pos from scratch; returns at once
+    void Start(const Position& pos) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            root = pos;
+            generation++;
+            running = true;
+            stats = PlayoutStats();
+            started = std::chrono::steady_clock::now();
+        }
+        wake.notify_all();
+    }
+
+    // Stop refining, e.g. once the game is over; the last estimate stays readable
+    void Stop() {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+
+    // Still adding playouts to the estimate
+    bool Refining() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return running && stats.Total() < limit;
+    }
+
+    PlayoutStats Stats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+private:
+    uint64_t limit;
+    std::vector<std::thread> workers;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    Position root;
+    uint64_t generation = 0;
+    bool running = false;
+    bool quit = false;
+    PlayoutStats stats;
+    std::chrono::steady_clock::time_point started;
+
+    void Work(int index) {
+        uint64_t random = uint64_t(std::chrono::steady_clock::now().time_since_epoch().count()) + uint64_t(index) * 0x9E3779B97F4A7C15ULL;
+        Position scratch;
+        Position start;
+        for (;;) {
+            uint64_t batchGeneration;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return quit || (running && stats.Total() < limit); });
+                if (quit) return;
+                start = root;
+                batchGeneration = generation;
+            }
+            int results[3] = {0, 0, 0};  // Black wins, draws, white wins
+            for (int i = 0; i < PlayoutBatch; i++) {
+                scratch = start;
+                results[Playout(scratch, random) + 1]++;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            if (batchGeneration != generation) continue;  // The position changed meanwhile
+            stats.blackWins += results[0];
+            stats.draws += results[1];
+            stats.whiteWins += results[2];
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+            stats.playoutsPerSec = seconds > 0 ? stats.Total() / seconds : 0;
+        }
+    }
+};
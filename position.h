@@ -0,0 +1,177 @@
+#pragma once
+#include <type_traits>
+#include "bitboard.h"
+#include "psqt.h"
+#include "zobrist.h"
+
+// Castling rights bits
+enum CastlingRight : uint8_t {
+    WhiteKingSide = 1,
+    WhiteQueenSide = 2,
+    BlackKingSide = 4,
+    BlackQueenSide = 8,
+    AllCastling = 15
+};
+
+// One piece of type p in a material signature
+constexpr uint64_t MaterialUnit(Piece p) { return 1ULL << (4 * p); }
+
+// Headless board state: everything the rules need, nothing the renderer owns.
+// A plain value type: copying a position is a single memcpy.
+struct Position {
+    Piece board[64];             // Mailbox: piece code on each square, NoPiece if empty
+    Bitboard pieces[PieceCount]; // One mask per piece code
+    Bitboard bySide[2];          // Union of each side's masks
+    Side sideToMove;
+    uint8_t castling;            // CastlingRight bits still available
+    int epSquare;                // Square a pawn skipped over last move, or NoSquare
+    int halfMoveClock;           // Half-moves since the last capture or pawn move
+    int fullMoveNumber;
+    Bitboard checkers;           // Enemy pieces giving check to the side to move
+    Bitboard pinned;             // Side-to-move pieces pinned to their own king
+    Key key;                     // Zobrist hash, kept up to date by every piece and state change
+    Key pawnKey;                 // Zobrist hash of the pawns alone
+    uint64_t material;           // Material signature: a 4-bit count per piece code
+    Score psq;                   // Material plus piece-square bonuses, white minus black
+    int phase;                   // Sum of PhaseWeights over the pieces on the board
+
+    void Clear() {
+        for (auto& p : board) p = NoPiece;
+        for (auto& b : pieces) b = 0;
+        bySide[White] = bySide[Black] = 0;
+        sideToMove = White;
+        castling = 0;
+        epSquare = NoSquare;
+        halfMoveClock = 0;
+        fullMoveNumber = 1;
+        checkers = pinned = 0;
+        key = pawnKey = 0;
+        material = 0;
+        psq = 0;
+        phase = 0;
+    }
+
+    Bitboard Occupied() const { return bySide[White] | bySide[Black]; }
+    Bitboard Pieces(Side side, PieceType type) const { return pieces[MakePiece(side, type)]; }
+    Bitboard Pieces(PieceType type) const { return pieces[type] | pieces[type + 6]; }
+
+    // What is on square sq (NoPiece if empty)
+    Piece PieceOn(int sq) const { return board[sq]; }
+
+    int KingSquare(Side side) const {
+        Bitboard king = Pieces(side, King);
+        return king ? Lsb(king) : NoSquare;
+    }
+
+    // Is sq attacked by any piece of side `by`
+    bool IsSquareAttacked(int sq, Side by) const {
+        return AttackersTo(sq, Occupied()) & bySide[by];
+    }
+
+    // All pieces of both sides attacking sq, with sliders seeing through `occupied`
+    Bitboard AttackersTo(int sq, Bitboard occupied) const {
+        return (PawnAttacks(Black, sq) & pieces[WhitePawn]) |
+               (PawnAttacks(White, sq) & pieces[BlackPawn]) |
+               (KnightAttacks(sq) & Pieces(Knight)) |
+               (KingAttacks(sq) & Pieces(King)) |
+               (BishopAttacks(sq, occupied) & (Pieces(Bishop) | Pieces(Queen))) |
+               (RookAttacks(sq, occupied) & (Pieces(Rook) | Pieces(Queen)));
+    }
+
+    bool InCheck(Side side) const {
+        int king = KingSquare(side);
+        return king != NoSquare && IsSquareAttacked(king, Opposite(side));
+    }
+
+    // Recompute checkers and pinned for the side to move; call after setting up a position
+    void UpdateCheckInfo() {
+        Side us = sideToMove;
+        Side them = Opposite(us);
+        int king = KingSquare(us);
+        checkers = pinned = 0;
+        if (king == NoSquare) return;
+
+        checkers = AttackersTo(king, Occupied()) & bySide[them];
+
+        // An enemy slider on an open line to the king, with exactly one of our pieces in between
+        Bitboard snipers = (RookAttacks(king, 0) & (Pieces(them, Rook) | Pieces(them, Queen))) |
+                           (BishopAttacks(king, 0) & (Pieces(them, Bishop) | Pieces(them, Queen)));
+        while (snipers) {
+            Bitboard blockers = Between(king, PopLsb(snipers)) & Occupied();
+            if (blockers && !(blockers & (blockers - 1)) && (blockers & bySide[us])) {
+                pinned |= blockers;
+            }
+        }
+    }
+
+    // Hash of the position from scratch; used after setup and to verify the incremental key
+    Key ComputeKey() const {
+        Key k = 0;
+        for (int p = 0; p < PieceCount; p++) {
+            for (Bitboard b = pieces[p]; b; ) k ^= Zobrist.piece[p][PopLsb(b)];
+        }
+        k ^= Zobrist.castling[castling];
+        if (epSquare != NoSquare) k ^= Zobrist.epFile[FileOf(epSquare)];
+        if (sideToMove == Black) k ^= Zobrist.side;
+        return k;
+    }
+
+    // Piece-square score from scratch, to verify the incremental one
+    Score ComputePsq() const {
+        Score s = 0;
+        for (int sq = 0; sq < 64; sq++) {
+            if (board[sq] != NoPiece) s += Psqt.score[board[sq]][sq];
+        }
+        return s;
+    }
+
+    void PutPiece(Piece p, int sq) {
+        board[sq] = p;
+        pieces[p] |= SquareBB(sq);
+        bySide[SideOf(p)] |= SquareBB(sq);
+        key ^= Zobrist.piece[p][sq];
+        if (TypeOf(p) == Pawn) pawnKey ^= Zobrist.piece[p][sq];
+        material += MaterialUnit(p);
+        psq += Psqt.score[p][sq];
+        phase += PhaseWeights[TypeOf(p)];
+    }
+
+    void RemovePiece(Piece p, int sq) {
+        board[sq] = NoPiece;
+        pieces[p] &= ~SquareBB(sq);
+        bySide[SideOf(p)] &= ~SquareBB(sq);
+        key ^= Zobrist.piece[p][sq];
+        if (TypeOf(p) == Pawn) pawnKey ^= Zobrist.piece[p][sq];
+        material -= MaterialUnit(p);
+        psq -= Psqt.score[p][sq];
+        phase -= PhaseWeights[TypeOf(p)];
+    }
+
+    void RemovePiece(int sq) {
+        Piece p = PieceOn(sq);
+        if (p != NoPiece) RemovePiece(p, sq);
+    }
+
+    void MovePiece(int from, int to) {
+        Piece p = PieceOn(from);
+        RemovePiece(to);
+        RemovePiece(from);
+        PutPiece(p, to);
+    }
+
+    void SetStartPosition() {
+        Clear();
+        const PieceType backRank[8] = {Rook, Knight, Bishop, Queen, King, Bishop, Knight, Rook};
+        for (int file = 0; file < 8; file++) {
+            PutPiece(MakePiece(White, backRank[file]), MakeSquare(file, 0));
+            PutPiece(WhitePawn, MakeSquare(file, 1));
+            PutPiece(BlackPawn, MakeSquare(file, 6));
+            PutPiece(MakePiece(Black, backRank[file]), MakeSquare(file, 7));
+        }
+        castling = AllCastling;
+        key = ComputeKey();
+        UpdateCheckInfo();
+    }
+};
+
+static_assert(std::is_trivially_copyable<Position>::value, "Position must stay memcpy-copyable");
@@ -0,0 +1,192 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Hot-path call counters and scoped timers, compiled in only with -DCHESS_PROFILE.
+// Without it PROFILE_SCOPE expands to nothing, so the rules code and the search pay
+// nothing in a normal build. Counts go to a per-thread block without atomics: the GUI
+// reads its own thread's block once per frame, and engine threads count into theirs
+// without disturbing the frame figures.
+//
+// FrameProfiler turns the GUI thread's counts into per-frame samples for the overlay
+// (frame-time percentiles, calls and time per frame) and for a JSON or CSV trace that
+// can be diffed between builds.
+
+enum ProfileCounter {
+    ProfileGenerateMoves,
+    ProfileMakeMove,
+    ProfileGameStatus,
+    ProfileInsufficientMaterial,
+    ProfileUiUpdate,
+    ProfileDrawBoardLayer,   // Re-rendering the cached board texture
+    ProfileDrawLayer,        // Blitting it
+    ProfileDrawHud,          // Selection, move dots and text
+    ProfileDrawOverlay,      // Promotion, game-over and profile overlays
+    ProfileCounterCount
+};
+
+const char* const ProfileCounterNames[ProfileCounterCount] = {
+    "GenerateMoves", "MakeMove", "GameStatus", "InsufficientMaterial", "UiUpdate",
+    "DrawBoardLayer", "DrawLayer", "DrawHud", "DrawOverlay",
+};
+
+struct ProfileSample {
+    uint64_t calls = 0;
+    uint64_t ns = 0;
+};
+
+struct ProfileCounters {
+    ProfileSample samples[ProfileCounterCount];
+};
+
+inline thread_local ProfileCounters ThreadProfile;
+
+#ifdef CHESS_PROFILE
+const bool ProfileEnabled = true;
+
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfileCounter counter) : counter(counter), start(std::chrono::steady_clock::now()) {}
+    ~ProfileScope() {
+        ProfileSample& sample = ThreadProfile.samples[counter];
+        sample.calls++;
+        sample.ns += uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    ProfileCounter counter;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define PROFILE_JOIN2(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN2(a, b)
+// Count the enclosing scope as one call of `counter` and add its duration
+#define PROFILE_SCOPE(counter) ProfileScope PROFILE_JOIN(profileScope, __LINE__)(counter)
+#else
+const bool ProfileEnabled = false;
+#define PROFILE_SCOPE(counter) ((void)0)
+#endif
+
+class FrameProfiler {
+public:
+    // Frames kept for the trace; a longer session keeps only the first ones
+    static const size_t MaxTraceFrames = 1 << 17;
+    // Frames the overlay's percentiles and averages cover
+    static const size_t WindowFrames = 240;
+
+    // Close a frame that took `frameMs` to build, taking this thread's counts since
+    // the previous call as its samples
+    void EndFrame(double frameMs) {
+        Frame frame;
+        frame.ms = float(frameMs);
+        for (int c = 0; c < ProfileCounterCount; c++) {
+            ProfileSample& now = ThreadProfile.samples[c];
+            frame.samples[c].calls = now.calls - taken.samples[c].calls;
+            frame.samples[c].ns = now.ns - taken.samples[c].ns;
+            total.samples[c].calls += frame.samples[c].calls;
+            total.samples[c].ns += frame.samples[c].ns;
+        }
+        taken = ThreadProfile;
+        if (window.size() < WindowFrames) window.push_back(frame);
+        else window[frameCount % WindowFrames] = frame;
+        if (trace.size() < MaxTraceFrames) trace.push_back(frame);
+        frameCount++;
+    }
+
+    size_t Frames() const { return frameCount; }
+
+    // Frame time (ms) at percentile p (0..100) over the recent window
+    double FramePercentile(double p) const {
+        if (window.empty()) return 0;
+        std::vector<float> ms;
+        ms.reserve(window.size());
+        for (const Frame& f : window) ms.push_back(f.ms);
+        return Percentile(ms, p);
+    }
+
+    // Average calls and microseconds per frame over the recent window
+    void Recent(ProfileCounter counter, double& callsPerFrame, double& usPerFrame) const {
+        callsPerFrame = usPerFrame = 0;
+        if (window.empty()) return;
+        for (const Frame& f : window) {
+            callsPerFrame += double(f.samples[counter].calls);
+            usPerFrame += f.samples[counter].ns / 1000.0;
+        }
+        callsPerFrame /= window.size();
+        usPerFrame /= window.size();
+    }
+
+    // A trace of every recorded frame: CSV with one row per frame if the path ends in
+    // ".csv", otherwise JSON with a summary followed by the per-frame arrays
+    bool WriteTrace(const char* path) const {
+        FILE* file = fopen(path, "w");
+        if (!file) return false;
+        size_t n = strlen(path);
+        if (n >= 4 && strcmp(path + n - 4, ".csv") == 0) WriteCsv(file);
+        else WriteJson(file);
+        return fclose(file) == 0;
+    }
+
+private:
+    struct Frame {
+        float ms = 0;
+        ProfileSample samples[ProfileCounterCount];
+    };
+    std::vector<Frame> window;   // Ring buffer of the last WindowFrames frames
+    std::vector<Frame> trace;
+    ProfileCounters taken;       // This thread's counts at the end of the previous frame
+    ProfileCounters total;
+    size_t frameCount = 0;
+
+    static double Percentile(std::vector<float> values, double p) {
+        if (values.empty()) return 0;
+        size_t k = std::min(values.size() - 1, size_t(p / 100.0 * (values.size() - 1) + 0.5));
+        std::nth_element(values.begin(), values.begin() + k, values.end());
+        return values[k];
+    }
+
+    void WriteCsv(FILE* file) const {
+        fprintf(file, "frame,frame_ms");
+        for (const char* name : ProfileCounterNames) fprintf(file, ",%s_calls,%s_us", name, name);
+        fprintf(file, "\n");
+        for (size_t i = 0; i < trace.size(); i++) {
+            fprintf(file, "%zu,%.4f", i, trace[i].ms);
+            for (const ProfileSample& s : trace[i].samples) fprintf(file, ",%llu,%.3f", (unsigned long long)s.calls, s.ns / 1000.0);
+            fprintf(file, "\n");
+        }
+    }
+
+    void WriteJson(FILE* file) const {
+        std::vector<float> ms;
+        for (const Frame& f : trace) ms.push_back(f.ms);
+        size_t frames = std::max<size_t>(frameCount, 1);
+        fprintf(file, "{\n  \"counters_enabled\": %s,\n  \"frames\": %zu,\n", ProfileEnabled ? "true" : "false", frameCount);
+        fprintf(file, "  \"frame_ms\": {\"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f},\n",
+                Percentile(ms, 50), Percentile(ms, 95), Percentile(ms, 99), Percentile(ms, 100));
+        fprintf(file, "  \"counters\": {\n");
+        for (int c = 0; c < ProfileCounterCount; c++) {
+            const ProfileSample& s = total.samples[c];
+            fprintf(file, "    \"%s\": {\"calls\": %llu, \"us\": %.3f, \"calls_per_frame\": %.3f, \"us_per_frame\": %.3f}%s\n",
+                    ProfileCounterNames[c], (unsigned long long)s.calls, s.ns / 1000.0, double(s.calls) / frames,
+                    s.ns / 1000.0 / frames, c + 1 < ProfileCounterCount ? "," : "");
+        }
+        fprintf(file, "  },\n  \"trace\": {\n    \"frame_ms\": [");
+        for (size_t i = 0; i < trace.size(); i++) fprintf(file, "%s%.4f", i ? ", " : "", trace[i].ms);
+        fprintf(file, "]");
+        for (int c = 0; c < ProfileCounterCount; c++) {
+            fprintf(file, ",\n    \"%s_calls\": [", ProfileCounterNames[c]);
+            for (size_t i = 0; i < trace.size(); i++) {
+                fprintf(file, "%s%llu", i ? ", " : "", (unsigned long long)trace[i].samples[c].calls);
+            }
+            fprintf(file, "]");
+        }
+        fprintf(file, "\n  }\n}\n");
+    }
+};
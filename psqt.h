@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include "piece.h"
+
+// A middlegame and an endgame value packed into one int, so both phases are
+// updated with a single add. The endgame half sits in the upper 16 bits.
+typedef int Score;
+
+constexpr Score MakeScore(int mg, int eg) { return int(unsigned(eg) << 16) + mg; }
+constexpr int MgScore(Score s) { return int16_t(uint16_t(unsigned(s))); }
+constexpr int EgScore(Score s) { return int16_t(uint16_t(unsigned(s + 0x8000) >> 16)); }
+
+// Game phase: 24 with all minor and major pieces on the board, 0 with none
+const int PhaseWeights[PieceTypeCount] = {0, 1, 1, 2, 4, 0};
+const int MaxPhase = 24;
+
+const Score PieceScores[PieceTypeCount] = {
+    MakeScore(82, 94), MakeScore(337, 281), MakeScore(365, 297),
+    MakeScore(477, 512), MakeScore(1025, 936), MakeScore(0, 0),
+};
+
+// Material plus square bonus for every piece code and square, white's point of view
+// (black entries are negated and mirrored). Generated at compile time from a few
+// shapes rather than written out square by square.
+struct PieceSquareTables {
+    Score score[PieceCount][64];
+};
+
+constexpr int Abs(int x) { return x < 0 ? -x : x; }
+constexpr int Max(int a, int b) { return a > b ? a : b; }
+
+// 0 on the four centre squares, 3 on the rim
+constexpr int CentreDistance(int file, int rank) {
+    return Max(Abs(2 * file - 7), Abs(2 * rank - 7)) / 2;
+}
+
+constexpr Score SquareBonus(PieceType type, int file, int rank) {
+    int centre = CentreDistance(file, rank);
+    switch (type) {
+        case Pawn: {
+            const int advanceMg[8] = {0, -5, 0, 5, 15, 25, 40, 0};
+            const int advanceEg[8] = {0, 0, 5, 15, 30, 50, 80, 0};
+            int central = (file == 3 || file == 4) && (rank == 3 || rank == 4) ? 15
+                        : (file == 2 || file == 5) && (rank == 3 || rank == 4) ? 5 : 0;
+            return MakeScore(advanceMg[rank] + central, advanceEg[rank]);
+        }
+        case Knight: return MakeScore(15 - 10 * centre, 10 - 8 * centre);
+        case Bishop: return MakeScore(10 - 5 * centre, 8 - 5 * centre);
+        case Rook:   return MakeScore(rank == 6 ? 20 : (file == 3 || file == 4) ? 5 : 0, rank == 6 ? 10 : 0);
+        case Queen:  return MakeScore(5 - 3 * centre, 10 - 5 * centre);
+        case King: {
+            // Tucked away behind pawns in the middlegame, centralised in the endgame
+            const int backRank[8] = {20, 30, 10, -5, 0, -5, 30, 20};
+            const int secondRank[8] = {10, 10, -5, -15, -15, -5, 10, 10};
+            int mg = rank == 0 ? backRank[file] : rank == 1 ? secondRank[file] : Max(-60, -20 - 15 * (rank - 2));
+            return MakeScore(mg, 30 - 15 * centre);
+        }
+        default: return 0;
+    }
+}
+
+constexpr PieceSquareTables MakePieceSquareTables() {
+    PieceSquareTables tables = {};
+    for (int type = Pawn; type < PieceTypeCount; type++) {
+        for (int sq = 0; sq < 64; sq++) {
+            int file = sq & 7, rank = sq >> 3;
+            Score white = PieceScores[type] + SquareBonus(PieceType(type), file, rank);
+            tables.score[type][sq] = white;
+            tables.score[type + 6][sq ^ 56] = -white;
+        }
+    }
+    return tables;
+}
+
+inline constexpr PieceSquareTables Psqt = MakePieceSquareTables();
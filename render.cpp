@@ -0,0 +1,226 @@
+// Headless diagram renderer: turns FENs into board images without opening a window,
+// using the GUI's piece atlas and square colours. PNGs are encoded in memory with
+// raylib's CPU-side image functions; SVG output needs no image decoding at all.
+// Build: g++ -O2 -std=c++17 render.cpp -o chess-render -lraylib -pthread
+//
+//   chess-render --fen FEN --out FILE.png|FILE.svg [--size N]       one diagram
+//   chess-render --batch FILE|- [--out DIR] [--svg] [--threads N] [--size N]
+//       one diagram per FEN line, rendered in parallel; without --out the images are
+//       encoded and discarded, which measures images/sec
+#include <raylib.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "atlas.h"
+#include "fen.h"
+
+// Piece sprites pre-scaled to one square size, shared read-only by every worker
+class PngRenderer {
+public:
+    PngRenderer(const char* imageDir, int squareSize) : squareSize(squareSize) {
+        pieces = LoadPieceAtlas(imageDir);
+        // Same proportions as the GUI, which draws the cell at half size on 100px squares
+        cellWidth = squareSize * AtlasCellWidth / 200;
+        cellHeight = squareSize * AtlasCellHeight / 200;
+        ImageResize(&pieces, cellWidth * PieceCount, cellHeight);
+    }
+    ~PngRenderer() { UnloadImage(pieces); }
+    PngRenderer(const PngRenderer&) = delete;
+    PngRenderer& operator=(const PngRenderer&) = delete;
+
+    bool Loaded() const { return pieces.data != nullptr; }
+
+    // Encoded PNG bytes of the diagram
+    std::string Render(const Position& pos) const {
+        Image board = GenImageColor(8 * squareSize, 8 * squareSize, LightSquareColor);
+        for (int row = 0; row < 8; row++) {
+            for (int col = (row + 1) % 2; col < 8; col += 2) {
+                ImageDrawRectangle(&board, col * squareSize, row * squareSize, squareSize, squareSize, DarkSquareColor);
+            }
+        }
+        for (int sq = 0; sq < 64; sq++) {
+            Piece p = pos.PieceOn(sq);
+            if (p == NoPiece) continue;
+            // Source and destination are the same size, so ImageDraw only blends
+            Rectangle source = {float(p * cellWidth), 0, float(cellWidth), float(cellHeight)};
+            Rectangle dest = {float(ColOf(sq) * squareSize + (squareSize - cellWidth) / 2),
+                              float(RowOf(sq) * squareSize + (squareSize - cellHeight) / 2),
+                              float(cellWidth), float(cellHeight)};
+            ImageDraw(&board, pieces, source, dest, WHITE);
+        }
+        int size = 0;
+        unsigned char* data = ExportImageToMemory(board, ".png", &size);
+        std::string png(reinterpret_cast<const char*>(data), data ? size : 0);
+        MemFree(data);
+        UnloadImage(board);
+        return png;
+    }
+
+private:
+    Image pieces;
+    int squareSize;
+    int cellWidth;
+    int cellHeight;
+};
+
+// Pieces as Unicode glyphs over coloured squares: text only, nothing to decode
+std::string RenderSvg(const Position& pos, int squareSize) {
+    // The solid glyph set (U+265A king .. U+265F pawn) for both sides, filled white or black
+    static const char* const glyphs[PieceTypeCount] = {"&#9823;", "&#9822;", "&#9821;", "&#9820;", "&#9819;", "&#9818;"};
+    auto hex = [](Color c) {
+        char buf[8];
+        snprintf(buf, sizeof(buf), "#%02x%02x%02x", c.r, c.g, c.b);
+        return std::string(buf);
+    };
+    int size = 8 * squareSize;
+    std::string svg;
+    svg.reserve(4096);
+    svg += "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" + std::to_string(size) + "\" height=\"" +
+           std::to_string(size) + "\" viewBox=\"0 0 " + std::to_string(size) + " " + std::to_string(size) + "\">\n";
+    svg += "<rect width=\"100%\" height=\"100%\" fill=\"" + hex(LightSquareColor) + "\"/>\n";
+    std::string dark = hex(DarkSquareColor);
+    for (int row = 0; row < 8; row++) {
+        for (int col = (row + 1) % 2; col < 8; col += 2) {
+            svg += "<rect x=\"" + std::to_string(col * squareSize) + "\" y=\"" + std::to_string(row * squareSize) +
+                   "\" width=\"" + std::to_string(squareSize) + "\" height=\"" + std::to_string(squareSize) +
+                   "\" fill=\"" + dark + "\"/>\n";
+        }
+    }
+    svg += "<g font-family=\"serif\" font-size=\"" + std::to_string(squareSize * 3 / 4) +
+           "\" text-anchor=\"middle\" dominant-baseline=\"central\" stroke=\"#000\" stroke-width=\"1\">\n";
+    for (int sq = 0; sq < 64; sq++) {
+        Piece p = pos.PieceOn(sq);
+        if (p == NoPiece) continue;
+        svg += "<text x=\"" + std::to_string(ColOf(sq) * squareSize + squareSize / 2) + "\" y=\"" +
+               std::to_string(RowOf(sq) * squareSize + squareSize / 2) + "\" fill=\"" +
+               (IsWhite(p) ? "#fff" : "#000") + "\">" + glyphs[TypeOf(p)] + "</text>\n";
+    }
+    svg += "</g>\n</svg>\n";
+    return svg;
+}
+
+bool WriteFile(const std::string& path, const std::string& data) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+    return fclose(file) == 0 && ok;
+}
+
+bool EndsWith(const std::string& s, const char* suffix) {
+    size_t n = strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+int main(int argc, char** argv) {
+    const char* fen = nullptr;
+    const char* batchPath = nullptr;
+    const char* outPath = nullptr;
+    const char* imageDir = "./Images";
+    bool svg = false;
+    int squareSize = 64;
+    int threads = int(std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--svg") == 0) svg = true;
+        else if (strcmp(argv[i], "--fen") == 0 && hasValue) fen = argv[++i];
+        else if (strcmp(argv[i], "--batch") == 0 && hasValue) batchPath = argv[++i];
+        else if (strcmp(argv[i], "--out") == 0 && hasValue) outPath = argv[++i];
+        else if (strcmp(argv[i], "--images") == 0 && hasValue) imageDir = argv[++i];
+        else if (strcmp(argv[i], "--size") == 0 && hasValue) squareSize = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue) threads = atoi(argv[++i]);
+        else fen = batchPath = nullptr, i = argc;
+    }
+    if (!fen == !batchPath || (fen && !outPath)) {
+        fprintf(stderr, "Usage: %s --fen FEN --out FILE.png|FILE.svg [--size N]\n"
+                        "       %s --batch FILE|- [--out DIR] [--svg] [--threads N] [--size N]\n", argv[0], argv[0]);
+        return 2;
+    }
+    if (threads < 1) threads = 1;
+    if (squareSize < 8) squareSize = 8;
+    if (fen) {
+        // One diagram's format comes from its file name; --svg may only agree with it
+        bool svgOut = EndsWith(outPath, ".svg");
+        if ((!svgOut && !EndsWith(outPath, ".png")) || (svg && !svgOut)) {
+            fprintf(stderr, "%s: --out must end in .png or .svg, and in .svg with --svg\n", outPath);
+            return 2;
+        }
+        svg = svgOut;
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+    std::unique_ptr<PngRenderer> png;
+    if (!svg) {
+        png.reset(new PngRenderer(imageDir, squareSize));
+        if (!png->Loaded()) {
+            fprintf(stderr, "Cannot load piece images from %s\n", imageDir);
+            return 2;
+        }
+    }
+    auto render = [&](const Position& pos) { return svg ? RenderSvg(pos, squareSize) : png->Render(pos); };
+
+    if (fen) {
+        Position pos;
+        if (!ParseFen(fen, pos)) {
+            fprintf(stderr, "Invalid FEN: %s\n", fen);
+            return 1;
+        }
+        if (!WriteFile(outPath, render(pos))) {
+            fprintf(stderr, "Cannot write %s\n", outPath);
+            return 2;
+        }
+        return 0;
+    }
+
+    std::vector<std::string> fens;
+    {
+        FILE* in = strcmp(batchPath, "-") == 0 ? stdin : fopen(batchPath, "r");
+        if (!in) {
+            fprintf(stderr, "Cannot open %s\n", batchPath);
+            return 2;
+        }
+        char line[512];
+        while (fgets(line, sizeof(line), in)) {
+            size_t n = strcspn(line, "\r\n");
+            if (n) fens.emplace_back(line, n);
+        }
+        if (in != stdin) fclose(in);
+    }
+
+    // Every diagram costs about the same, so workers just take the next index
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> invalid{0}, failed{0}, bytes{0};
+    auto worker = [&]() {
+        Position pos;
+        for (size_t i = next++; i < fens.size(); i = next++) {
+            if (!ParseFen(fens[i], pos)) {
+                invalid++;
+                continue;
+            }
+            std::string image = render(pos);
+            bytes += image.size();
+            if (outPath) {
+                char name[32];
+                snprintf(name, sizeof(name), "/%06zu.%s", i + 1, svg ? "svg" : "png");
+                if (!WriteFile(outPath + std::string(name), image)) failed++;
+            }
+        }
+    };
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) workers.emplace_back(worker);
+    for (auto& t : workers) t.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t rendered = fens.size() - invalid;
+    printf("Rendered %zu %s diagrams (%zu invalid FENs, %zu write errors) with %d threads\n", rendered,
+           svg ? "SVG" : "PNG", size_t(invalid), size_t(failed), threads);
+    printf("Time: %.3fs  Images/sec: %.0f  Average size: %.0f bytes\n", seconds,
+           rendered / (seconds > 0 ? seconds : 1e-9), rendered ? double(bytes) / rendered : 0.0);
+    return invalid || failed ? 1 : 0;
+}
@@ -0,0 +1,310 @@
+// Game-database validator: replays every game of a PGN file through the rules and
+// checks the recorded result against mate, stalemate and draw conditions.
+// Build: g++ -O2 -std=c++17 scan.cpp -o chess-scan -pthread
+//
+//   chess-scan FILE [--threads N] [--errors OUT] [--top N]   validate and print statistics
+//   chess-scan FILE --scaling [--max-threads N]              games/sec for 1, 2, 4, 8... threads
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "pgn.h"
+
+// Chunks are cut just before a tag section that follows a blank line, so no game spans two
+const size_t ChunkBytes = 1 << 20;
+
+struct Chunk {
+    const char* begin;
+    const char* end;
+};
+
+std::vector<Chunk> SplitIntoGames(const char* data, size_t size, size_t chunkBytes) {
+    std::vector<Chunk> chunks;
+    const char* end = data + size;
+    const char* start = data;
+    while (start < end) {
+        const char* cut = start + chunkBytes < end ? start + chunkBytes : end;
+        while (cut < end) {
+            const char* nl = static_cast<const char*>(memchr(cut, '\n', size_t(end - cut)));
+            if (!nl || nl + 1 >= end) {
+                cut = end;
+                break;
+            }
+            cut = nl + 1;
+            // "\n\n[" or "\n\r\n["
+            const char* prev = nl > data && nl[-1] == '\r' ? nl - 1 : nl;
+            if (*cut == '[' && prev > data && prev[-1] == '\n') break;
+        }
+        chunks.push_back({start, cut});
+        start = cut;
+    }
+    return chunks;
+}
+
+enum ScanResult { ResultWhite, ResultBlack, ResultDraw, ResultUnknown, ResultCount };
+enum DrawReason { DrawStalemate, DrawMaterial, DrawRepetition, DrawFiftyMoves, DrawOther, DrawReasonCount };
+
+const char* const ResultNames[ResultCount] = {"1-0", "0-1", "1/2-1/2", "*"};
+const char* const DrawReasonNames[DrawReasonCount] = {
+    "stalemate", "insufficient material", "threefold repetition", "50-move rule", "agreement/other"};
+
+struct ScanStats {
+    uint64_t games = 0;
+    uint64_t plies = 0;
+    uint64_t invalid = 0;
+    uint64_t results[ResultCount] = {};
+    uint64_t drawReasons[DrawReasonCount] = {};
+    uint64_t checkmates = 0;
+    std::unordered_map<std::string, uint64_t> openings;
+    std::vector<std::pair<size_t, std::string>> errors; // (byte offset, message)
+
+    void Merge(const ScanStats& other) {
+        games += other.games;
+        plies += other.plies;
+        invalid += other.invalid;
+        for (int i = 0; i < ResultCount; i++) results[i] += other.results[i];
+        for (int i = 0; i < DrawReasonCount; i++) drawReasons[i] += other.drawReasons[i];
+        checkmates += other.checkmates;
+        for (const auto& entry : other.openings) openings[entry.first] += entry.second;
+        errors.insert(errors.end(), other.errors.begin(), other.errors.end());
+    }
+};
+
+ScanResult ToScanResult(std::string_view result) {
+    if (result == "1-0") return ResultWhite;
+    if (result == "0-1") return ResultBlack;
+    if (result == "1/2-1/2") return ResultDraw;
+    return ResultUnknown;
+}
+
+// ECO code when tagged, else the first two moves of each side in SAN
+std::string OpeningOf(const PgnGame& pgn) {
+    std::string_view eco = pgn.Tag("ECO");
+    if (!eco.empty()) return std::string(eco);
+    std::string line;
+    Position pos = pgn.game.start;
+    for (size_t i = 0; i < pgn.game.moves.size() && i < 4; i++) {
+        if (i) line += ' ';
+        line += MoveToSan(pos, pgn.game.moves[i]);
+        UndoInfo undo;
+        MakeMove(pos, pgn.game.moves[i], undo);
+    }
+    return line.empty() ? "(no moves)" : line;
+}
+
+// Check one replayed game against the rules and add it to stats
+void ScanGame(const PgnGame& pgn, ScanStats& stats) {
+    const Game& game = pgn.game;
+    const Position& pos = game.pos;
+    stats.games++;
+    stats.plies += game.moves.size();
+
+    ScanResult result = ToScanResult(pgn.result);
+    stats.results[result]++;
+    std::string_view tagged = pgn.Tag("Result");
+
+    std::string error = pgn.error;
+    if (error.empty() && pgn.result.empty()) error = "movetext has no result";
+    if (error.empty() && !tagged.empty() && tagged != pgn.result) {
+        error = "Result tag " + std::string(tagged) + " does not match movetext " + std::string(pgn.result);
+    }
+
+    if (error.empty()) {
+        MoveList legal;
+        GenerateMoves(pos, legal);
+        GameStatus status = game.Status(legal);
+        if (IsCheckmate(pos, legal)) {
+            stats.checkmates++;
+            ScanResult expected = status.outcome == WhiteWins ? ResultWhite : ResultBlack;
+            if (result != expected && result != ResultUnknown) {
+                error = std::string("checkmate recorded as ") + ResultNames[result];
+            }
+        } else if (IsStalemate(pos, legal) || IsDeadPosition(pos)) {
+            // FIDE dead positions only: a won knight-pair ending is a legal result
+            // even though the GUI scores it as drawn
+            if (result == ResultWhite || result == ResultBlack) {
+                error = std::string(status.message) + " but recorded as " + ResultNames[result];
+            }
+        }
+
+        if (result == ResultDraw) {
+            DrawReason reason = DrawOther;
+            if (IsStalemate(pos, legal)) reason = DrawStalemate;
+            else if (IsDeadPosition(pos)) reason = DrawMaterial;
+            else if (game.Repetitions() >= 2) reason = DrawRepetition;
+            else if (pos.halfMoveClock >= 100) reason = DrawFiftyMoves;
+            stats.drawReasons[reason]++;
+        }
+    }
+
+    if (!error.empty()) {
+        stats.invalid++;
+        stats.errors.push_back({pgn.offset, error});
+    }
+    stats.openings[OpeningOf(pgn)]++;
+}
+
+// Per-worker deques of chunk indices. A worker takes from the front of its own deque
+// and, once it runs dry, steals from the back of the others'.
+class WorkStealingQueues {
+public:
+    WorkStealingQueues(size_t items, int workers) {
+        for (int w = 0; w < workers; w++) {
+            queues.emplace_back(new Queue);
+            // Contiguous blocks, so each worker starts on neighbouring parts of the file
+            for (size_t i = items * w / workers; i < items * (w + 1) / workers; i++) {
+                queues.back()->items.push_back(i);
+            }
+        }
+    }
+
+    bool Pop(int self, size_t& item) {
+        {
+            Queue& own = *queues[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.items.empty()) {
+                item = own.items.front();
+                own.items.pop_front();
+                return true;
+            }
+        }
+        for (size_t i = 1; i < queues.size(); i++) {
+            Queue& victim = *queues[(self + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.items.empty()) {
+                item = victim.items.back();
+                victim.items.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> items;
+    };
+    std::vector<std::unique_ptr<Queue>> queues;
+};
+
+ScanStats RunScan(const MappedFile& file, int threads) {
+    std::vector<Chunk> chunks = SplitIntoGames(file.Data(), file.Size(), ChunkBytes);
+    WorkStealingQueues work(chunks.size(), threads);
+    std::vector<ScanStats> perThread(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            PgnGame pgn;
+            size_t index;
+            while (work.Pop(t, index)) {
+                const Chunk& chunk = chunks[index];
+                PgnParser parser(chunk.begin, chunk.end);
+                while (parser.Next(pgn)) {
+                    pgn.offset += size_t(chunk.begin - file.Data());
+                    ScanGame(pgn, perThread[t]);
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+
+    ScanStats total;
+    for (const ScanStats& stats : perThread) total.Merge(stats);
+    std::sort(total.errors.begin(), total.errors.end());
+    return total;
+}
+
+void PrintStats(const ScanStats& stats, int top) {
+    auto percent = [&](uint64_t n) { return stats.games ? 100.0 * n / stats.games : 0.0; };
+    printf("Games: %llu  Invalid: %llu  Checkmates: %llu  Average length: %.1f plies\n",
+           (unsigned long long)stats.games, (unsigned long long)stats.invalid,
+           (unsigned long long)stats.checkmates, stats.games ? double(stats.plies) / stats.games : 0.0);
+    printf("\nResults\n");
+    for (int i = 0; i < ResultCount; i++) {
+        printf("  %-8s %12llu  %5.1f%%\n", ResultNames[i], (unsigned long long)stats.results[i],
+               percent(stats.results[i]));
+    }
+    printf("\nDraws by final position\n");
+    for (int i = 0; i < DrawReasonCount; i++) {
+        printf("  %-22s %12llu\n", DrawReasonNames[i], (unsigned long long)stats.drawReasons[i]);
+    }
+
+    std::vector<std::pair<uint64_t, std::string>> openings;
+    for (const auto& entry : stats.openings) openings.push_back({entry.second, entry.first});
+    std::sort(openings.begin(), openings.end(),
+              [](const auto& a, const auto& b) { return a.first != b.first ? a.first > b.first : a.second < b.second; });
+    printf("\nMost frequent openings\n");
+    for (int i = 0; i < top && i < int(openings.size()); i++) {
+        printf("  %-28s %12llu  %5.1f%%\n", openings[i].second.c_str(), (unsigned long long)openings[i].first,
+               percent(openings[i].first));
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* path = nullptr;
+    const char* errorPath = nullptr;
+    int threads = int(std::thread::hardware_concurrency());
+    int maxThreads = threads;
+    int top = 10;
+    bool scaling = false;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--scaling") == 0) scaling = true;
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--max-threads") == 0 && hasValue) maxThreads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--errors") == 0 && hasValue) errorPath = argv[++i];
+        else if (strcmp(argv[i], "--top") == 0 && hasValue) top = atoi(argv[++i]);
+        else if (argv[i][0] != '-' && !path) path = argv[i];
+        else path = nullptr, i = argc;
+    }
+    if (!path) {
+        fprintf(stderr, "Usage: %s FILE [--threads N | --scaling [--max-threads N]] [--errors OUT] [--top N]\n", argv[0]);
+        return 2;
+    }
+    if (threads < 1) threads = 1;
+    if (maxThreads < 1) maxThreads = 1;
+
+    MappedFile file;
+    if (!file.Open(path)) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return 2;
+    }
+
+    if (scaling) {
+        printf("%8s %14s %10s %10s\n", "threads", "games/sec", "speedup", "time");
+        double baseRate = 0;
+        for (int n = 1; n <= maxThreads; n *= 2) {
+            auto start = std::chrono::steady_clock::now();
+            ScanStats stats = RunScan(file, n);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            double rate = stats.games / (seconds > 0 ? seconds : 1e-9);
+            if (n == 1) baseRate = rate;
+            printf("%8d %14.0f %9.2fx %9.3fs\n", n, rate, rate / baseRate, seconds);
+        }
+        return 0;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    ScanStats stats = RunScan(file, threads);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    FILE* errors = errorPath ? fopen(errorPath, "w") : stderr;
+    if (!errors) {
+        fprintf(stderr, "Cannot write %s\n", errorPath);
+        return 2;
+    }
+    for (const auto& error : stats.errors) fprintf(errors, "offset %zu: %s\n", error.first, error.second.c_str());
+    if (errorPath) fclose(errors);
+
+    PrintStats(stats, top);
+    printf("\nThreads: %d  Time: %.3fs  Games/sec: %.0f\n", threads, seconds,
+           stats.games / (seconds > 0 ? seconds : 1e-9));
+    return stats.invalid ? 1 : 0;
+}
@@ -0,0 +1,456 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "eval.h"
+#include "game.h"
+#include "nnue.h"
+#include "movegen.h"
+#include "tb.h"
+#include "tt.h"
+
+const int MaxPly = 128;
+const int Infinity = 32001;
+const int MateScore = 32000;            // Mate at the root; mate in N plies scores MateScore - N
+const int MateBound = MateScore - MaxPly - TbLoss; // Room for a tablebase mate probed at any ply
+
+// How long to think; zero means unlimited for that dimension
+struct SearchLimits {
+    int depth = MaxPly - 1;
+    uint64_t nodes = 0;
+    int64_t movetimeMs = 0;
+};
+
+// Reported by the main searcher after each completed iteration
+struct SearchInfo {
+    int depth;
+    int score;
+    uint64_t nodes;   // All threads
+    int64_t timeMs;
+    Move bestMove;
+};
+
+struct SearchResult {
+    Move bestMove = NullMove;
+    int score = 0;
+    int depth = 0;
+    uint64_t nodes = 0;
+};
+
+// Mate scores are stored relative to the node, not the root
+inline int ScoreToTT(int score, int ply) {
+    return score >= MateBound ? score + ply : score <= -MateBound ? score - ply : score;
+}
+
+inline int ScoreFromTT(int score, int ply) {
+    return score >= MateBound ? score - ply : score <= -MateBound ? score + ply : score;
+}
+
+// A tablebase verdict at ply as a search score: its mates rank like mates found by search
+inline int TbScore(uint8_t value, int ply) {
+    if (TbIsWin(value)) return MateScore - ply - TbPlies(value);
+    if (TbIsLoss(value)) return -MateScore + ply + TbPlies(value);
+    return 0;
+}
+
+// Lazy SMP depth staggering: helper thread i skips iterations in blocks of
+// SkipSize[i] plies starting at SkipPhase[i], so helpers spread over several depths
+const int SkipSize[20] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+const int SkipPhase[20] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+// Iterative-deepening negamax alpha-beta with quiescence search and a shared
+// transposition table. Moves are ordered by the hash move, MVV-LVA for captures,
+// then killer moves, then history.
+class Searcher {
+public:
+    // threadIndex 0 is the main thread, which alone enforces time and node limits;
+    // nodeCounter accumulates the nodes of every thread searching together
+    Searcher(TranspositionTable& table, int threadIndex, std::atomic<uint64_t>& nodeCounter)
+        : tt(&table), index(threadIndex), sharedNodes(&nodeCounter) {}
+
+    // gameKeys holds the keys of the positions played so far, ending with root
+    SearchResult Run(const Position& root, const std::vector<Key>& gameKeys,
+                     const SearchLimits& searchLimits, std::atomic<bool>& stopFlag) {
+        pos = root;
+        if (nnue) nnue->Refresh(pos, accumulators[0]);
+        // Positions before the last capture or pawn move can never repeat
+        keyCount = 0;
+        size_t first = gameKeys.size() > MaxHistory ? gameKeys.size() - MaxHistory : 0;
+        for (size_t i = first; i < gameKeys.size(); i++) keys[keyCount++] = gameKeys[i];
+        if (keyCount == 0) keys[keyCount++] = pos.key;
+        limits = searchLimits;
+        stop = &stopFlag;
+        nodes = reportedNodes = 0;
+        rootDepth = 0;
+        start = std::chrono::steady_clock::now();
+        memset(killers, 0, sizeof(killers));
+        // Older history still hints at good quiet moves, but counts for less
+        for (auto& side : history) for (auto& from : side) for (int& h : from) h /= 2;
+
+        SearchResult result;
+        MoveList rootMoves;
+        GenerateMoves(pos, rootMoves);
+        if (rootMoves.Size() == 0) return result;
+        result.bestMove = rootMoves[0]; // Something legal even if stopped immediately
+
+        // A tabled root has a known best move: no search needed
+        uint8_t tbValue;
+        Move tbMove = tablebase ? tablebase->BestMove(pos, tbValue) : NullMove;
+        if (tbMove != NullMove) {
+            result.bestMove = tbMove;
+            result.score = TbScore(tbValue, 0);
+            result.depth = 1;
+            if (onIteration) onIteration({1, result.score, 0, ElapsedMs(), tbMove});
+            return result;
+        }
+
+        for (rootDepth = 1; rootDepth <= limits.depth; rootDepth++) {
+            if (index > 0 && rootDepth > 1) {
+                int i = (index - 1) % 20;
+                if (((rootDepth + SkipPhase[i]) / SkipSize[i]) % 2) continue;
+            }
+            if (Stopped() && rootDepth > 1) break;
+
+            rootBestMove = NullMove;
+            int score = Negamax(rootDepth, 0, -Infinity, Infinity);
+            if (Stopped() && rootDepth > 1) break; // Discard the unfinished iteration
+
+            result.bestMove = rootBestMove;
+            result.score = score;
+            result.depth = rootDepth;
+            if (onIteration) {
+                CheckLimits(); // Flushes this thread's node count
+                onIteration({rootDepth, score, sharedNodes->load(std::memory_order_relaxed),
+                             ElapsedMs(), rootBestMove});
+            }
+            if (score >= MateBound || score <= -MateBound) break; // Forced mate found
+        }
+        sharedNodes->fetch_add(nodes - reportedNodes, std::memory_order_relaxed);
+        result.nodes = nodes;
+        return result;
+    }
+
+    // Called after each completed iteration (set on the main searcher only)
+    std::function<void(const SearchInfo&)> onIteration;
+
+    const PawnTable& Pawns() const { return pawnTable; }
+
+    // Evaluate with this network instead of the classical evaluation (nullptr for classical)
+    void SetNetwork(const NnueNetwork* network) { nnue = network; }
+    // Score tabled positions by lookup (nullptr to search them)
+    void SetTablebase(const Tablebase* tables) { tablebase = tables; }
+
+private:
+    TranspositionTable* tt;
+    int index;
+    std::atomic<uint64_t>* sharedNodes;
+    uint64_t reportedNodes = 0;
+    Position pos;
+    SearchLimits limits;
+    std::atomic<bool>* stop = nullptr;
+    std::chrono::steady_clock::time_point start;
+    uint64_t nodes = 0;
+    int rootDepth = 0;
+    Move rootBestMove = NullMove;
+    static const int MaxHistory = 256;
+    static const int HistoryMax = 1 << 14;
+    Key keys[MaxHistory + MaxPly];   // Game history followed by the current search path
+    int keyCount = 0;
+    Move killers[MaxPly][2];
+    int history[2][64][64] = {};     // Quiet cutoff scores in [0, HistoryMax), below the killers
+    PawnTable pawnTable;             // Per thread, kept across searches
+    const NnueNetwork* nnue = nullptr;
+    const Tablebase* tablebase = nullptr;
+    NnueAccumulator accumulators[MaxPly + 1]; // One per ply; taking a move back just drops a level
+
+    int Eval(int ply) {
+        return nnue ? nnue->Evaluate(accumulators[ply], pos.sideToMove) : Evaluate(pos, pawnTable);
+    }
+
+    // Play m at ply, carrying the NNUE accumulator forward
+    void DoMove(Move m, int ply, UndoInfo& undo) {
+        MakeMove(pos, m, undo);
+        if (nnue) nnue->Update(pos, m, undo.captured, accumulators[ply], accumulators[ply + 1]);
+    }
+
+    bool Stopped() const { return stop->load(std::memory_order_relaxed); }
+
+    int64_t ElapsedMs() const {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Polled every few thousand nodes; depth 1 always completes so there is a move to play
+    void CheckLimits() {
+        uint64_t total = sharedNodes->fetch_add(nodes - reportedNodes, std::memory_order_relaxed) +
+                         nodes - reportedNodes;
+        reportedNodes = nodes;
+        if (index > 0 || rootDepth <= 1) return;
+        if (limits.nodes && total >= limits.nodes) stop->store(true);
+        if (limits.movetimeMs && ElapsedMs() >= limits.movetimeMs) stop->store(true);
+    }
+
+    // Higher scores are searched first
+    int ScoreMove(Move m, int ply, Move hashMove) const {
+        if (m == hashMove) return 2000000;
+        if (IsCapture(m) || IsPromotion(m)) {
+            PieceType victim = MoveFlags(m) == EnPassant ? Pawn
+                             : IsCapture(m) ? TypeOf(pos.PieceOn(MoveTo(m))) : Pawn;
+            PieceType attacker = TypeOf(pos.PieceOn(MoveFrom(m)));
+            int promotion = IsPromotion(m) ? PieceValues[PromotionType(m)] : 0;
+            return 1000000 + (IsCapture(m) ? PieceValues[victim] * 16 - attacker : 0) + promotion;
+        }
+        if (m == killers[ply][0]) return 900000;
+        if (m == killers[ply][1]) return 800000;
+        return history[pos.sideToMove][MoveFrom(m)][MoveTo(m)];
+    }
+
+    // Selection sort step: swap the best remaining move into slot i
+    static void PickNext(MoveList& moves, int* scores, int i) {
+        int best = i;
+        for (int j = i + 1; j < moves.count; j++) {
+            if (scores[j] > scores[best]) best = j;
+        }
+        std::swap(moves.moves[i], moves.moves[best]);
+        std::swap(scores[i], scores[best]);
+    }
+
+    int Negamax(int depth, int ply, int alpha, int beta) {
+        if ((++nodes & 2047) == 0) CheckLimits();
+        if (Stopped() && rootDepth > 1) return 0;
+        if (ply > 0 && (pos.halfMoveClock >= 100 ||
+                        CountRepetitions(keys, keyCount, pos.halfMoveClock) > 0)) {
+            return 0; // Draw by the 50-move rule or by repeating a position
+        }
+        uint8_t tbValue;
+        if (ply > 0 && tablebase && PopCount(pos.Occupied()) <= tablebase->MaxPieces() && tablebase->Probe(pos, tbValue)) {
+            return TbScore(tbValue, ply);
+        }
+
+        bool inCheck = pos.checkers != 0;
+        if (inCheck && ply < MaxPly / 2) depth++; // Check extension
+        if (depth <= 0) return Quiesce(ply, alpha, beta);
+
+        TTData entry = {NullMove, 0, 0, BoundNone};
+        if (tt->Probe(pos.key, entry) && ply > 0 && entry.depth >= depth) {
+            int score = ScoreFromTT(entry.score, ply);
+            if (entry.bound == BoundExact ||
+                (entry.bound == BoundLower && score >= beta) ||
+                (entry.bound == BoundUpper && score <= alpha)) {
+                return score;
+            }
+        }
+
+        MoveList moves;
+        GenerateMoves(pos, moves);
+        if (moves.Size() == 0) return inCheck ? -MateScore + ply : 0;
+        if (ply >= MaxPly - 1) return Eval(ply);
+
+        int scores[256];
+        for (int i = 0; i < moves.count; i++) scores[i] = ScoreMove(moves[i], ply, entry.move);
+
+        int originalAlpha = alpha;
+        int best = -Infinity;
+        Move bestMove = NullMove;
+        for (int i = 0; i < moves.count; i++) {
+            PickNext(moves, scores, i);
+            Move m = moves[i];
+
+            UndoInfo undo;
+            DoMove(m, ply, undo);
+            keys[keyCount++] = pos.key;
+            int score = -Negamax(depth - 1, ply + 1, -beta, -alpha);
+            keyCount--;
+            UnmakeMove(pos, m, undo);
+            if (Stopped() && rootDepth > 1) return 0;
+
+            if (score > best) {
+                best = score;
+                bestMove = m;
+                if (ply == 0) rootBestMove = m;
+            }
+            if (score > alpha) alpha = score;
+            if (alpha >= beta) {
+                if (!IsCapture(m) && !IsPromotion(m)) {
+                    if (killers[ply][0] != m) {
+                        killers[ply][1] = killers[ply][0];
+                        killers[ply][0] = m;
+                    }
+                    // Gravity update: grows by depth squared, but ever more slowly
+                    // toward HistoryMax, so it can never outrank a killer or overflow
+                    int& h = history[pos.sideToMove][MoveFrom(m)][MoveTo(m)];
+                    int bonus = std::min(depth * depth, HistoryMax);
+                    h += bonus - h * bonus / HistoryMax;
+                }
+                break;
+            }
+        }
+
+        Bound bound = best >= beta ? BoundLower : best > originalAlpha ? BoundExact : BoundUpper;
+        tt->Store(pos.key, bestMove, ScoreToTT(best, ply), depth, bound);
+        return best;
+    }
+
+    // Resolve captures (and check evasions) until the position is quiet
+    int Quiesce(int ply, int alpha, int beta) {
+        if ((++nodes & 2047) == 0) CheckLimits();
+        if (Stopped() && rootDepth > 1) return 0;
+
+        bool inCheck = pos.checkers != 0;
+        MoveList moves;
+        GenerateMoves(pos, moves);
+        if (moves.Size() == 0) return inCheck ? -MateScore + ply : 0;
+        if (ply >= MaxPly - 1) return Eval(ply);
+
+        int best = -Infinity;
+        if (!inCheck) {
+            best = Eval(ply); // Stand pat
+            if (best >= beta) return best;
+            if (best > alpha) alpha = best;
+        }
+
+        // Out of check only captures and promotions are searched; quiet moves are
+        // dropped here rather than relied on to sort last
+        if (!inCheck) {
+            int tactical = 0;
+            for (int i = 0; i < moves.count; i++) {
+                if (IsCapture(moves[i]) || IsPromotion(moves[i])) moves.moves[tactical++] = moves[i];
+            }
+            moves.count = tactical;
+        }
+
+        int scores[256];
+        for (int i = 0; i < moves.count; i++) scores[i] = ScoreMove(moves[i], ply, NullMove);
+
+        for (int i = 0; i < moves.count; i++) {
+            PickNext(moves, scores, i);
+            Move m = moves[i];
+
+            UndoInfo undo;
+            DoMove(m, ply, undo);
+            int score = -Quiesce(ply + 1, -beta, -alpha);
+            UnmakeMove(pos, m, undo);
+            if (Stopped() && rootDepth > 1) return 0;
+
+            if (score > best) best = score;
+            if (score > alpha) alpha = score;
+            if (alpha >= beta) break;
+        }
+        return best;
+    }
+};
+
+// Lazy SMP: N Searchers on their own threads share one transposition table and
+// one stop flag. The main searcher enforces the limits and supplies the result;
+// helpers search the same root at staggered depths and feed the table. The whole
+// search runs off the caller's thread, so a GUI frame loop never blocks.
+class SearchPool {
+public:
+    explicit SearchPool(TranspositionTable& table, int threads = 1) : tt(&table) { SetThreads(threads); }
+
+    ~SearchPool() {
+        Stop();
+        Join();
+    }
+
+    void SetThreads(int threads) {
+        Join();
+        std::function<void(const SearchInfo&)> callback;
+        if (!searchers.empty()) callback = searchers[0]->onIteration;
+        searchers.clear();
+        for (int i = 0; i < (threads > 0 ? threads : 1); i++) {
+            searchers.emplace_back(new Searcher(*tt, i, nodeCount));
+            searchers.back()->SetNetwork(nnue);
+            searchers.back()->SetTablebase(tablebase);
+        }
+        searchers[0]->onIteration = callback;
+    }
+
+    int Threads() const { return int(searchers.size()); }
+
+    // Use a network for evaluation in every thread, or nullptr for the classical evaluation.
+    // The network must outlive its use by the pool.
+    void SetNetwork(const NnueNetwork* network) {
+        Join();
+        nnue = network;
+        for (auto& searcher : searchers) searcher->SetNetwork(network);
+    }
+
+    // Endgame tables for every thread, or nullptr; must outlive their use by the pool
+    void SetTablebase(const Tablebase* tables) {
+        Join();
+        tablebase = tables;
+        for (auto& searcher : searchers) searcher->SetTablebase(tables);
+    }
+
+    // Pawn hash lookups of all threads since they were created
+    void PawnStats(uint64_t& hits, uint64_t& misses) const {
+        hits = misses = 0;
+        for (const auto& searcher : searchers) {
+            hits += searcher->Pawns().hits;
+            misses += searcher->Pawns().misses;
+        }
+    }
+
+    void SetInfoCallback(std::function<void(const SearchInfo&)> callback) {
+        Join();
+        searchers[0]->onIteration = callback;
+    }
+
+    void Start(const Position& pos, const std::vector<Key>& gameKeys, const SearchLimits& limits) {
+        Join();
+        stopFlag = false;
+        done = false;
+        nodeCount = 0;
+        tt->NewSearch();
+        controller = std::thread([this, pos, gameKeys, limits] {
+            std::vector<std::thread> helpers;
+            for (size_t i = 1; i < searchers.size(); i++) {
+                helpers.emplace_back([this, i, &pos, &gameKeys, &limits] {
+                    searchers[i]->Run(pos, gameKeys, limits, stopFlag);
+                });
+            }
+            SearchResult main = searchers[0]->Run(pos, gameKeys, limits, stopFlag);
+            stopFlag = true;
+            for (auto& helper : helpers) helper.join();
+            main.nodes = nodeCount;
+            result = main;
+            done = true;
+        });
+    }
+
+    bool IsRunning() const { return controller.joinable() && !done; }
+    bool IsDone() const { return controller.joinable() && done; }
+    void Stop() { stopFlag = true; }
+
+    // Blocks until the search has finished and returns its result
+    SearchResult Wait() {
+        Join();
+        return result;
+    }
+
+    SearchResult Search(const Position& pos, const std::vector<Key>& gameKeys, const SearchLimits& limits) {
+        Start(pos, gameKeys, limits);
+        return Wait();
+    }
+
+private:
+    TranspositionTable* tt;
+    const NnueNetwork* nnue = nullptr;
+    const Tablebase* tablebase = nullptr;
+    std::vector<std::unique_ptr<Searcher>> searchers;
+    std::thread controller;
+    std::atomic<bool> stopFlag{false};
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> nodeCount{0};
+    SearchResult result;
+
+    void Join() {
+        if (controller.joinable()) controller.join();
+    }
+};
@@ -0,0 +1,380 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "mmap.h"
+#include "movegen.h"
+
+// Endgame tablebases: the perfect-play result and distance to mate of every position
+// with up to four pieces, one byte per position, from the side to move's point of view.
+// Tables are generated by chess-tb (tbgen.cpp) and memory-mapped here, so a probe is a
+// handful of square transformations and one byte read.
+//
+// Castling rights are never part of an endgame table, and the 50-move rule is ignored:
+// a mate in 60 moves is still reported as a win.
+
+const uint8_t TbDraw = 0;
+const uint8_t TbLoss = 128;      // TbLoss + n: the side to move is mated in n plies
+const uint8_t TbInvalid = 255;   // Not a legal position with this side to move
+// 1..127: the side to move mates in that many plies
+
+inline bool TbIsWin(uint8_t v) { return v > TbDraw && v < TbLoss; }
+inline bool TbIsLoss(uint8_t v) { return v >= TbLoss && v != TbInvalid; }
+inline int TbPlies(uint8_t v) { return TbIsLoss(v) ? v - TbLoss : v; }
+
+const int TbMaxPieces = 4;
+const char* const TbPieceLetters = "PNBRQK";
+
+// Exchange the white and black halves of a material signature
+inline uint64_t FlipMaterial(uint64_t material) {
+    return (material & 0xFFFFFFULL) << 24 | material >> 24;
+}
+
+// Which pieces a table holds and how its positions are numbered:
+//   index = ((kingIndex * 64 + blackKing) * 64 + piece1) * 64 + piece2
+// Pawnless tables fold the white king into the a1-d1-d4 triangle with the eight board
+// symmetries (10 king squares); tables with pawns can only mirror left to right, so the
+// white king stays on files a-d (32 squares). The stronger side is always white; a
+// position with the colours the other way round is probed with the board flipped.
+struct TbLayout {
+    uint64_t material = 0;             // Position::material of the tabled position, kings included
+    Piece pieces[TbMaxPieces - 2];     // Non-king pieces in index order, white first
+    int count = 0;
+    bool pawns = false;
+    size_t size = 0;                   // Positions per side to move
+
+    std::string Name() const {
+        std::string sides[2] = {"K", "K"};
+        for (int i = 0; i < count; i++) sides[SideOf(pieces[i])] += TbPieceLetters[TypeOf(pieces[i])];
+        return sides[White] + "v" + sides[Black];
+    }
+};
+
+inline TbLayout MakeTbLayout(std::vector<PieceType> white, std::vector<PieceType> black) {
+    // Strongest first within a side, and the side with more or stronger pieces is white
+    std::sort(white.begin(), white.end(), [](PieceType a, PieceType b) { return a > b; });
+    std::sort(black.begin(), black.end(), [](PieceType a, PieceType b) { return a > b; });
+    if (black.size() > white.size() || (black.size() == white.size() && black > white)) std::swap(white, black);
+    TbLayout layout;
+    layout.material = MaterialUnit(WhiteKing) + MaterialUnit(BlackKing);
+    for (PieceType t : white) layout.pieces[layout.count++] = MakePiece(White, t);
+    for (PieceType t : black) layout.pieces[layout.count++] = MakePiece(Black, t);
+    for (int i = 0; i < layout.count; i++) {
+        layout.material += MaterialUnit(layout.pieces[i]);
+        if (TypeOf(layout.pieces[i]) == Pawn) layout.pawns = true;
+    }
+    layout.size = (layout.pawns ? 32 : 10) * 64;
+    for (int i = 0; i < layout.count; i++) layout.size *= 64;
+    return layout;
+}
+
+// "KQvKR" and the like; false if the name is not a table of at most TbMaxPieces
+inline bool ParseTbName(const std::string& name, TbLayout& layout) {
+    size_t v = name.find('v');
+    if (name.size() < 3 || name[0] != 'K' || v == std::string::npos || v + 1 >= name.size() || name[v + 1] != 'K') {
+        return false;
+    }
+    std::vector<PieceType> sides[2];
+    for (size_t i = 1; i < name.size(); i++) {
+        if (i == v || i == v + 1) continue;
+        const char* letter = name[i] ? strchr(TbPieceLetters, name[i]) : nullptr;
+        if (!letter || *letter == 'K') return false;
+        sides[i < v ? White : Black].push_back(PieceType(letter - TbPieceLetters));
+    }
+    if (sides[White].size() + sides[Black].size() + 2 > size_t(TbMaxPieces)) return false;
+    layout = MakeTbLayout(sides[White], sides[Black]);
+    return true;
+}
+
+// Every table with 3..maxPieces pieces, in an order where each table's captures and
+// promotions lead only into tables listed before it: fewer pieces first, then fewer pawns
+inline std::vector<TbLayout> AllTbLayouts(int maxPieces = TbMaxPieces) {
+    const PieceType types[5] = {Queen, Rook, Bishop, Knight, Pawn};
+    std::vector<TbLayout> layouts;
+    for (int a = 0; a < 5; a++) {
+        layouts.push_back(MakeTbLayout({types[a]}, {}));
+        if (maxPieces < 4) continue;
+        for (int b = a; b < 5; b++) {
+            layouts.push_back(MakeTbLayout({types[a], types[b]}, {}));
+            layouts.push_back(MakeTbLayout({types[a]}, {types[b]}));
+        }
+    }
+    auto pawnCount = [](const TbLayout& l) {
+        int n = 0;
+        for (int i = 0; i < l.count; i++) n += TypeOf(l.pieces[i]) == Pawn;
+        return n;
+    };
+    std::stable_sort(layouts.begin(), layouts.end(), [&](const TbLayout& x, const TbLayout& y) {
+        return x.count != y.count ? x.count < y.count : pawnCount(x) < pawnCount(y);
+    });
+    return layouts;
+}
+
+// The white king's squares in pawnless tables: a1 b1 c1 d1 b2 c2 d2 c3 d3 d4
+const int TbTriangle[10] = {0, 1, 2, 3, 9, 10, 11, 18, 19, 27};
+
+inline int TbKingIndex(bool pawns, int sq) {
+    if (pawns) return RankOf(sq) * 4 + FileOf(sq);
+    for (int i = 0; i < 10; i++) {
+        if (TbTriangle[i] == sq) return i;
+    }
+    return -1;
+}
+
+inline int TbKingSquare(bool pawns, int index) {
+    return pawns ? MakeSquare(index % 4, index / 4) : TbTriangle[index];
+}
+
+// Symmetry bits: 1 mirrors files, 2 mirrors ranks, 4 reflects in the a1-h8 diagonal
+inline int TbApplySymmetry(int symmetry, int sq) {
+    if (symmetry & 1) sq ^= 7;
+    if (symmetry & 2) sq ^= 56;
+    if (symmetry & 4) sq = (sq & 7) << 3 | sq >> 3;
+    return sq;
+}
+
+inline int TbSymmetryFor(bool pawns, int whiteKing) {
+    int symmetry = 0;
+    if (FileOf(whiteKing) > 3) symmetry |= 1, whiteKing ^= 7;
+    if (pawns) return symmetry;
+    if (RankOf(whiteKing) > 3) symmetry |= 2, whiteKing ^= 56;
+    if (RankOf(whiteKing) > FileOf(whiteKing)) symmetry |= 4;
+    return symmetry;
+}
+
+// Index of already oriented squares: white king, black king, then the pieces in slot order
+inline size_t TbIndexWith(const TbLayout& layout, const int* squares, int symmetry) {
+    int sq[TbMaxPieces];
+    for (int i = 0; i < layout.count + 2; i++) sq[i] = TbApplySymmetry(symmetry, squares[i]);
+    // Twins are interchangeable, so they are stored in square order
+    for (int i = 3; i < layout.count + 2; i++) {
+        if (layout.pieces[i - 2] == layout.pieces[i - 3] && sq[i] < sq[i - 1]) std::swap(sq[i], sq[i - 1]);
+    }
+    size_t index = TbKingIndex(layout.pawns, sq[0]);
+    for (int i = 1; i < layout.count + 2; i++) index = index * 64 + sq[i];
+    return index;
+}
+
+// Index of pos in a table of `layout`. With `flip` the position holds the tabled
+// material with the colours exchanged, so it is read upside down with colours swapped.
+// `stm` receives the side to move as the table sees it.
+inline size_t TbIndexOf(const TbLayout& layout, const Position& pos, bool flip, Side& stm) {
+    int flipSquare = flip ? 56 : 0;
+    int squares[TbMaxPieces];
+    squares[0] = pos.KingSquare(flip ? Black : White) ^ flipSquare;
+    squares[1] = pos.KingSquare(flip ? White : Black) ^ flipSquare;
+    Bitboard used = 0;
+    for (int i = 0; i < layout.count; i++) {
+        Piece p = layout.pieces[i];
+        int sq = Lsb(pos.pieces[flip ? MakePiece(Opposite(SideOf(p)), TypeOf(p)) : p] & ~used);
+        used |= SquareBB(sq);
+        squares[i + 2] = sq ^ flipSquare;
+    }
+    stm = flip ? Opposite(pos.sideToMove) : pos.sideToMove;
+    int symmetry = TbSymmetryFor(layout.pawns, squares[0]);
+    size_t index = TbIndexWith(layout, squares, symmetry);
+    // The diagonal reflection leaves a king on a1-d4 in place, so both orientations
+    // describe the position; the smaller index is the one stored
+    int king = TbApplySymmetry(symmetry, squares[0]);
+    if (!layout.pawns && RankOf(king) == FileOf(king)) index = std::min(index, TbIndexWith(layout, squares, symmetry | 4));
+    return index;
+}
+
+// Set up the position at `index`; false if it is not a legal position for `stm` or
+// another index stores the same position
+inline bool TbDecode(const TbLayout& layout, size_t index, Side stm, Position& pos) {
+    size_t stored = index;
+    int squares[TbMaxPieces - 2];
+    for (int i = layout.count - 1; i >= 0; i--) {
+        squares[i] = int(index % 64);
+        index /= 64;
+    }
+    int blackKing = int(index % 64);
+    int whiteKing = TbKingSquare(layout.pawns, int(index / 64));
+    if (whiteKing == blackKing || (KingAttacks(whiteKing) & SquareBB(blackKing))) return false;
+
+    pos.Clear();
+    pos.PutPiece(WhiteKing, whiteKing);
+    pos.PutPiece(BlackKing, blackKing);
+    for (int i = 0; i < layout.count; i++) {
+        int sq = squares[i];
+        if (pos.PieceOn(sq) != NoPiece) return false;
+        if (TypeOf(layout.pieces[i]) == Pawn && (RankOf(sq) == 0 || RankOf(sq) == 7)) return false;
+        pos.PutPiece(layout.pieces[i], sq);
+    }
+    pos.sideToMove = stm;
+    pos.key = pos.ComputeKey();
+    pos.UpdateCheckInfo();
+    if (pos.InCheck(Opposite(stm))) return false;  // The side that just moved cannot be in check
+    Side ignored;
+    return TbIndexOf(layout, pos, false, ignored) == stored;
+}
+
+// "White mates in 12", "Draw" and the like for a value with `stm` to move
+inline std::string TbVerdict(Side stm, uint8_t value) {
+    const char* names[2] = {"White", "Black"};
+    if (TbIsWin(value)) return std::string(names[stm]) + " mates in " + std::to_string((TbPlies(value) + 1) / 2);
+    if (TbIsLoss(value)) {
+        if (TbPlies(value) == 0) return std::string(names[stm]) + " is checkmated";
+        return std::string(names[Opposite(stm)]) + " mates in " + std::to_string(TbPlies(value) / 2);
+    }
+    return "Draw";
+}
+
+// Can the side to move capture en passant? Such positions are not indexed.
+inline bool TbHasEpCapture(const Position& pos) {
+    Side us = pos.sideToMove;
+    return pos.epSquare != NoSquare && (PawnAttacks(Opposite(us), pos.epSquare) & pos.Pieces(us, Pawn));
+}
+
+// File layout: this header, then `size` bytes with white to move and `size` with black
+struct TbHeader {
+    char magic[8];       // "CHSTB001"
+    uint64_t material;
+    uint64_t size;
+    uint32_t maxPlies;   // Longest mate in the table, for the generator of dependent tables
+    uint8_t reserved[36];
+};
+static_assert(sizeof(TbHeader) == 64, "Tablebase header is 64 bytes");
+
+class Tablebase {
+public:
+    Tablebase() = default;
+    Tablebase(const Tablebase&) = delete;
+    Tablebase& operator=(const Tablebase&) = delete;
+
+    // Map every table of dir that exists; returns how many were found
+    int Load(const std::string& dir) {
+        int found = 0;
+        for (const TbLayout& layout : AllTbLayouts()) {
+            if (Has(layout.material)) continue;
+            std::unique_ptr<Table> table(new Table);
+            table->layout = layout;
+            std::string path = dir + "/" + layout.Name() + ".tb";
+            if (!table->file.Open(path.c_str(), MADV_RANDOM)) continue;
+            TbHeader header;
+            if (table->file.Size() != sizeof(header) + 2 * layout.size) continue;
+            memcpy(&header, table->file.Data(), sizeof(header));
+            if (memcmp(header.magic, "CHSTB001", 8) != 0 || header.material != layout.material) continue;
+            table->data = reinterpret_cast<const uint8_t*>(table->file.Data()) + sizeof(header);
+            table->maxPlies = int(header.maxPlies);
+            Insert(std::move(table));
+            found++;
+        }
+        return found;
+    }
+
+    // A table produced in memory by the generator
+    void Add(const TbLayout& layout, std::vector<uint8_t> values, int maxPlies) {
+        std::unique_ptr<Table> table(new Table);
+        table->layout = layout;
+        table->owned = std::move(values);
+        table->data = table->owned.data();
+        table->maxPlies = maxPlies;
+        Insert(std::move(table));
+    }
+
+    bool Has(uint64_t material) const { return byMaterial.count(material) != 0; }
+    int Count() const { return int(tables.size()); }
+    int MaxPieces() const { return maxPieces; }
+
+    // Longest mate over all tables, an upper bound for conversions into them
+    int MaxPlies() const {
+        int plies = 0;
+        for (const auto& table : tables) plies = std::max(plies, table->maxPlies);
+        return plies;
+    }
+
+    // Value of pos for its side to move, or false if no table covers it
+    bool Probe(const Position& pos, uint8_t& value) const {
+        if (pos.castling) return false;
+        int pieces = PopCount(pos.Occupied());
+        if (pieces == 2) {
+            value = TbDraw;
+            return true;
+        }
+        if (pieces > maxPieces) return false;
+        if (TbHasEpCapture(pos)) return ProbeMoves(pos, value);
+
+        bool flip = false;
+        auto it = byMaterial.find(pos.material);
+        if (it == byMaterial.end()) {
+            it = byMaterial.find(FlipMaterial(pos.material));
+            if (it == byMaterial.end()) return false;
+            flip = true;
+        }
+        const Table& table = *it->second;
+        Side stm;
+        size_t index = TbIndexOf(table.layout, pos, flip, stm);
+        value = table.data[stm * table.layout.size + index];
+        return value != TbInvalid;
+    }
+
+    // The move keeping the best result: the fastest mate when winning, a drawing move
+    // when drawn, the longest resistance when lost. NullMove if pos is not covered.
+    Move BestMove(const Position& pos, uint8_t& value) const {
+        if (!Probe(pos, value)) return NullMove;
+        MoveList moves;
+        GenerateMoves(pos, moves);
+        Move best = NullMove;
+        int bestRank = -1000;
+        for (Move m : moves) {
+            Position child = pos;
+            UndoInfo undo;
+            MakeMove(child, m, undo);
+            uint8_t v;
+            if (!Probe(child, v)) return NullMove;
+            // From the mover's side: child losses are wins for us, shorter is better
+            int rank = TbIsLoss(v) ? 500 - TbPlies(v) : TbIsWin(v) ? -500 + TbPlies(v) : 0;
+            if (rank > bestRank) bestRank = rank, best = m;
+        }
+        return best;
+    }
+
+private:
+    struct Table {
+        TbLayout layout;
+        MappedFile file;
+        std::vector<uint8_t> owned;
+        const uint8_t* data = nullptr;
+        int maxPlies = 0;
+    };
+    std::vector<std::unique_ptr<Table>> tables;
+    std::unordered_map<uint64_t, const Table*> byMaterial;
+    int maxPieces = 2;
+
+    void Insert(std::unique_ptr<Table> table) {
+        byMaterial[table->layout.material] = table.get();
+        maxPieces = std::max(maxPieces, table->layout.count + 2);
+        tables.push_back(std::move(table));
+    }
+
+    // One ply of minimax over tabled children, for positions the index cannot express
+    bool ProbeMoves(const Position& pos, uint8_t& value) const {
+        MoveList moves;
+        GenerateMoves(pos, moves);
+        if (moves.Size() == 0) {
+            value = pos.checkers ? TbLoss : TbDraw;
+            return true;
+        }
+        int minLoss = -1, maxWin = -1;
+        bool allWins = true;
+        for (Move m : moves) {
+            Position child = pos;
+            UndoInfo undo;
+            MakeMove(child, m, undo);
+            uint8_t v;
+            if (!Probe(child, v)) return false;
+            if (TbIsLoss(v) && (minLoss < 0 || TbPlies(v) < minLoss)) minLoss = TbPlies(v);
+            if (TbIsWin(v)) maxWin = std::max(maxWin, TbPlies(v));
+            else allWins = false;
+        }
+        value = minLoss >= 0 ? uint8_t(minLoss + 1) : allWins ? uint8_t(TbLoss + maxWin + 1) : TbDraw;
+        return true;
+    }
+};
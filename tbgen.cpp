@@ -0,0 +1,381 @@
+// Endgame tablebase generator and prober for tb.h tables.
+// Build: g++ -O2 -std=c++17 tbgen.cpp -o chess-tb -pthread
+//
+//   chess-tb generate DIR [--threads N] [--pieces 3|4] [TABLE...]
+//       write DIR/KQvKR.tb and friends; without TABLE names every table up to --pieces
+//       is built, smallest first, and tables already in DIR are reused
+//   chess-tb probe DIR FEN
+//       the tablebase verdict and best move for a position
+//   chess-tb bench DIR [--count N]
+//       probes/sec over random positions of the loaded tables
+//
+// Generation is retrograde analysis by forward iteration. Every position starts out
+// unresolved (stored as a draw); pass 0 marks the mates, and pass n marks a position
+// won in n plies if one of its moves reaches a position lost in n-1, or lost in n
+// plies if every move reaches a position won in at most n-1 with one exactly n-1.
+// Moves that capture or promote lead into smaller, finished tables. Whatever is still
+// unresolved once passes stop finding anything is a draw. Each pass reads the previous
+// pass's values and writes a copy, so positions can be split across threads freely.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "fen.h"
+#include "tb.h"
+
+// Split [0, count) into chunks handed to `threads` workers as they finish
+template <typename F>
+void ParallelFor(size_t count, int threads, F body) {
+    const size_t chunk = 1 << 14;
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t begin = next.fetch_add(chunk); begin < count; begin = next.fetch_add(chunk)) {
+            body(begin, std::min(begin + chunk, count));
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++) workers.emplace_back(worker);
+    worker();
+    for (auto& t : workers) t.join();
+}
+
+class TbGenerator {
+public:
+    TbGenerator(const TbLayout& layout, const Tablebase& tablebase, int threads)
+        : layout(layout), tablebase(tablebase), threads(threads) {}
+
+    // False if a capture or promotion leads into a table that is not loaded
+    bool Run() {
+        size_t total = 2 * layout.size;
+        values.assign(total, TbDraw);
+        wake.assign(total, 0);
+        flags.reset(new std::atomic<uint8_t>[total]);
+        for (size_t i = 0; i < total; i++) flags[i].store(0, std::memory_order_relaxed);
+
+        ParallelFor(total, threads, [&](size_t begin, size_t end) {
+            Position pos;
+            for (size_t i = begin; i < end; i++) {
+                if (!Decode(i, pos)) values[i] = TbInvalid;
+            }
+        });
+        // Pass 0 finds the mates and notes when conversions can first decide a position
+        next = values;
+        ParallelFor(total, threads, [&](size_t begin, size_t end) {
+            Position pos;
+            for (size_t i = begin; i < end; i++) {
+                if (values[i] != TbInvalid && Decode(i, pos)) Resolve(i, pos, 0);
+            }
+        });
+        values.swap(next);
+
+        // A conversion can resolve a position as late as the longest mate it leads into
+        int lastConversion = tablebase.MaxPlies() + 1;
+        for (int n = 1;; n++) {
+            if (n >= TbLoss - 1) {
+                fprintf(stderr, "%s: a mate longer than %d plies does not fit\n", layout.Name().c_str(), TbLoss - 2);
+                return false;
+            }
+            next = values;
+            std::atomic<bool> changed{false};
+            uint8_t due = MarkBit(n);
+            ParallelFor(total, threads, [&](size_t begin, size_t end) {
+                Position pos;
+                bool any = false;
+                for (size_t i = begin; i < end; i++) {
+                    uint8_t f = flags[i].load(std::memory_order_relaxed);
+                    if (f & due) flags[i].fetch_and(uint8_t(~due), std::memory_order_relaxed);
+                    if (values[i] != TbDraw || !(f & (due | EpParent) || wake[i] == n)) continue;
+                    Decode(i, pos);
+                    any |= Resolve(i, pos, n);
+                }
+                if (any) changed = true;
+            });
+            values.swap(next);
+            if (missing) {
+                fprintf(stderr, "%s: a capture or promotion leads into a table that is not loaded\n", layout.Name().c_str());
+                return false;
+            }
+            if (changed) maxPlies = n;
+            else if (n > lastConversion) break;
+        }
+        return true;
+    }
+
+    std::vector<uint8_t>& Values() { return values; }
+    int MaxPlies() const { return maxPlies; }
+
+private:
+    // flags bits: a predecessor of something resolved last pass, alternating by pass
+    // parity, and "has a double push answered by en passant", examined every pass
+    static const uint8_t EpParent = 4;
+    static uint8_t MarkBit(int n) { return uint8_t(1 << (n & 1)); }
+
+    const TbLayout& layout;
+    const Tablebase& tablebase;
+    int threads;
+    std::vector<uint8_t> values, next;
+    std::vector<uint8_t> wake;  // Next pass a conversion can decide the position, 0 if none
+    std::unique_ptr<std::atomic<uint8_t>[]> flags;
+    std::atomic<bool> missing{false};
+    int maxPlies = 0;
+
+    bool Decode(size_t i, Position& pos) const {
+        return TbDecode(layout, i % layout.size, i < layout.size ? White : Black, pos);
+    }
+
+    // Value of a move's result as of the previous pass, TbDraw while it is unresolved
+    uint8_t ChildValue(const Position& child, bool& conversion) {
+        conversion = child.material != layout.material;
+        if (conversion) {
+            uint8_t v = TbDraw;
+            if (!tablebase.Probe(child, v)) missing = true;
+            return v;
+        }
+        if (TbHasEpCapture(child)) {
+            MoveList moves;
+            GenerateMoves(child, moves);
+            int minLoss = -1, maxWin = -1;
+            bool allWins = true, ignored;
+            for (Move m : moves) {
+                Position grandchild = child;
+                UndoInfo undo;
+                MakeMove(grandchild, m, undo);
+                uint8_t v = ChildValue(grandchild, ignored);
+                if (TbIsLoss(v) && (minLoss < 0 || TbPlies(v) < minLoss)) minLoss = TbPlies(v);
+                if (TbIsWin(v)) maxWin = std::max(maxWin, TbPlies(v));
+                else allWins = false;
+            }
+            // Pawn moves always exist here, so there is no mate or stalemate to find
+            return minLoss >= 0 ? uint8_t(minLoss + 1) : allWins ? uint8_t(TbLoss + maxWin + 1) : TbDraw;
+        }
+        Side stm;
+        size_t index = TbIndexOf(layout, child, false, stm);
+        return values[stm * layout.size + index];
+    }
+
+    // Decide position i at pass n: a win in exactly n plies, a loss in exactly n, or
+    // nothing yet, in which case the next pass a conversion could decide it is noted.
+    // Only a move reaching something decided at pass n-1 can change the answer.
+    bool Resolve(size_t i, const Position& pos, int n) {
+        MoveList moves;
+        GenerateMoves(pos, moves);
+        if (moves.Size() == 0) {
+            if (!pos.checkers) return false;  // Stalemate
+            next[i] = TbLoss;
+            MarkPredecessors(pos, n + 1);
+            return true;
+        }
+        int minLoss = -1, maxWin = -1, nextConversion = 0;
+        bool allWins = true;
+        for (Move m : moves) {
+            Position child = pos;
+            UndoInfo undo;
+            MakeMove(child, m, undo);
+            bool conversion;
+            uint8_t v = ChildValue(child, conversion);
+            if (TbIsLoss(v) && (minLoss < 0 || TbPlies(v) < minLoss)) minLoss = TbPlies(v);
+            if (TbIsWin(v)) maxWin = std::max(maxWin, TbPlies(v));
+            else allWins = false;
+            if (conversion && v != TbDraw && TbPlies(v) + 1 > n && (!nextConversion || TbPlies(v) + 1 < nextConversion)) {
+                nextConversion = TbPlies(v) + 1;
+            }
+            if (n == 0 && MoveFlags(m) == DoublePush && TbHasEpCapture(child)) flags[i] |= EpParent;
+        }
+        uint8_t v = TbDraw;
+        if (n % 2 == 1 && minLoss == n - 1) v = uint8_t(n);
+        else if (n > 0 && n % 2 == 0 && allWins && maxWin == n - 1) v = uint8_t(TbLoss + n);
+        if (v == TbDraw) {
+            wake[i] = uint8_t(nextConversion);
+            return false;
+        }
+        next[i] = v;
+        MarkPredecessors(pos, n + 1);
+        return true;
+    }
+
+    // Flag every position that reaches pos in one move without capturing or promoting,
+    // for examination at `pass`
+    void MarkPredecessors(const Position& pos, int pass) {
+        Side mover = Opposite(pos.sideToMove);
+        Bitboard occupied = pos.Occupied();
+        auto mark = [&](int from, int to) {
+            Position previous = pos;
+            previous.MovePiece(to, from);
+            previous.sideToMove = mover;
+            Side stm;
+            size_t index = TbIndexOf(layout, previous, false, stm);
+            flags[stm * layout.size + index].fetch_or(MarkBit(pass), std::memory_order_relaxed);
+        };
+        for (Bitboard pieces = pos.bySide[mover]; pieces; ) {
+            int to = PopLsb(pieces);
+            Bitboard from = 0;
+            switch (TypeOf(pos.PieceOn(to))) {
+                case Pawn: {
+                    int back = mover == White ? -8 : 8;
+                    int rank = mover == White ? RankOf(to) : 7 - RankOf(to);
+                    if (rank >= 2 && !(occupied & SquareBB(to + back))) {
+                        from |= SquareBB(to + back);
+                        if (rank == 3 && !(occupied & SquareBB(to + 2 * back))) from |= SquareBB(to + 2 * back);
+                    }
+                    break;
+                }
+                case Knight: from = KnightAttacks(to); break;
+                case Bishop: from = BishopAttacks(to, occupied); break;
+                case Rook: from = RookAttacks(to, occupied); break;
+                case Queen: from = QueenAttacks(to, occupied); break;
+                case King: from = KingAttacks(to); break;
+                default: break;
+            }
+            for (from &= ~occupied; from; ) mark(PopLsb(from), to);
+        }
+    }
+};
+
+bool WriteTable(const std::string& path, const TbLayout& layout, const std::vector<uint8_t>& values, int maxPlies) {
+    TbHeader header = {};
+    memcpy(header.magic, "CHSTB001", 8);
+    header.material = layout.material;
+    header.size = layout.size;
+    header.maxPlies = uint32_t(maxPlies);
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(values.data(), 1, values.size(), file) == values.size();
+    return fclose(file) == 0 && ok;
+}
+
+void PrintStats(const TbLayout& layout, const std::vector<uint8_t>& values, int maxPlies, double seconds) {
+    const char* sides[2] = {"wtm", "btm"};
+    printf("%-7s %11zu positions  %6.2fs  longest mate %d plies\n", layout.Name().c_str(), values.size(), seconds, maxPlies);
+    for (int stm = 0; stm < 2; stm++) {
+        size_t wins = 0, draws = 0, losses = 0, invalid = 0;
+        for (size_t i = stm * layout.size; i < (stm + 1) * layout.size; i++) {
+            uint8_t v = values[i];
+            if (v == TbInvalid) invalid++;
+            else if (TbIsWin(v)) wins++;
+            else if (TbIsLoss(v)) losses++;
+            else draws++;
+        }
+        printf("        %s: %zu wins, %zu draws, %zu losses, %zu invalid\n", sides[stm], wins, draws, losses, invalid);
+    }
+    fflush(stdout);  // Progress through a long run
+}
+
+int Generate(const std::string& dir, int threads, int maxPieces, const std::vector<std::string>& names) {
+    std::vector<TbLayout> layouts = AllTbLayouts(maxPieces);
+    if (!names.empty()) {
+        std::vector<TbLayout> wanted;
+        for (const std::string& name : names) {
+            TbLayout layout;
+            if (!ParseTbName(name, layout)) {
+                fprintf(stderr, "Unknown table %s\n", name.c_str());
+                return 2;
+            }
+            wanted.push_back(layout);
+        }
+        // Keep the dependency order whatever order the names came in
+        layouts.erase(std::remove_if(layouts.begin(), layouts.end(), [&](const TbLayout& l) {
+            return std::none_of(wanted.begin(), wanted.end(), [&](const TbLayout& w) { return w.material == l.material; });
+        }), layouts.end());
+    }
+
+    Tablebase tablebase;
+    int existing = tablebase.Load(dir);
+    if (existing) printf("Using %d tables already in %s\n", existing, dir.c_str());
+    for (const TbLayout& layout : layouts) {
+        if (tablebase.Has(layout.material)) continue;
+        auto start = std::chrono::steady_clock::now();
+        TbGenerator generator(layout, tablebase, threads);
+        if (!generator.Run()) return 1;
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        PrintStats(layout, generator.Values(), generator.MaxPlies(), seconds);
+        std::string path = dir + "/" + layout.Name() + ".tb";
+        if (!WriteTable(path, layout, generator.Values(), generator.MaxPlies())) {
+            fprintf(stderr, "Cannot write %s\n", path.c_str());
+            return 2;
+        }
+        tablebase.Add(layout, std::move(generator.Values()), generator.MaxPlies());
+    }
+    return 0;
+}
+
+int Probe(const std::string& dir, const char* fen) {
+    Tablebase tablebase;
+    tablebase.Load(dir);
+    Position pos;
+    if (!ParseFen(fen, pos)) {
+        fprintf(stderr, "Invalid FEN: %s\n", fen);
+        return 1;
+    }
+    uint8_t value;
+    Move best = tablebase.BestMove(pos, value);
+    if (!tablebase.Probe(pos, value)) {
+        printf("Not in the tablebase (%d tables loaded)\n", tablebase.Count());
+        return 1;
+    }
+    printf("%s", TbVerdict(pos.sideToMove, value).c_str());
+    if (best != NullMove) printf(", best move %s", MoveToUci(best).c_str());
+    printf("\n");
+    return 0;
+}
+
+// Random legal positions of every loaded table, probed back to back
+int Bench(const std::string& dir, int count) {
+    Tablebase tablebase;
+    if (tablebase.Load(dir) == 0) {
+        fprintf(stderr, "No tables in %s\n", dir.c_str());
+        return 1;
+    }
+    std::vector<Position> positions;
+    uint64_t seed = 1;
+    std::vector<TbLayout> layouts = AllTbLayouts(tablebase.MaxPieces());
+    while (int(positions.size()) < count) {
+        const TbLayout& layout = layouts[SplitMix64(seed) % layouts.size()];
+        if (!tablebase.Has(layout.material)) continue;
+        Position pos;
+        Side stm = Side(SplitMix64(seed) & 1);
+        if (TbDecode(layout, SplitMix64(seed) % layout.size, stm, pos)) positions.push_back(pos);
+    }
+    auto start = std::chrono::steady_clock::now();
+    uint64_t sum = 0;
+    for (const Position& pos : positions) {
+        uint8_t value = 0;
+        tablebase.Probe(pos, value);
+        sum += value;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%d tables, %zu probes in %.3fs: %.0f probes/sec (checksum %llu)\n", tablebase.Count(), positions.size(),
+           seconds, positions.size() / (seconds > 0 ? seconds : 1e-9), (unsigned long long)sum);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    std::string command = argc > 2 ? argv[1] : "";
+    std::string dir = argc > 2 ? argv[2] : "";
+    int threads = int(std::thread::hardware_concurrency());
+    int maxPieces = TbMaxPieces;
+    int count = 1000000;
+    std::vector<std::string> args;
+    for (int i = 3; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--threads") == 0 && hasValue) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--pieces") == 0 && hasValue) maxPieces = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--count") == 0 && hasValue) count = atoi(argv[++i]);
+        else args.push_back(argv[i]);
+    }
+    if (threads < 1) threads = 1;
+    maxPieces = std::min(std::max(maxPieces, 3), TbMaxPieces);
+
+    if (command == "generate") return Generate(dir, threads, maxPieces, args);
+    if (command == "probe" && args.size() == 1) return Probe(dir, args[0].c_str());
+    if (command == "bench" && args.empty()) return Bench(dir, std::max(count, 1));
+    fprintf(stderr, "Usage: %s generate DIR [--threads N] [--pieces 3|4] [TABLE...]\n"
+                    "       %s probe DIR FEN\n"
+                    "       %s bench DIR [--count N]\n", argv[0], argv[0], argv[0]);
+    return 2;
+}
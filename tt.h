@@ -0,0 +1,141 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "move.h"
+#include "zobrist.h"
+
+enum Bound : uint8_t {
+    BoundNone = 0,
+    BoundUpper = 1,  // Score is at most this (fail low)
+    BoundLower = 2,  // Score is at least this (fail high)
+    BoundExact = 3
+};
+
+struct TTData {
+    Move move;
+    int score;
+    int depth;
+    Bound bound;
+};
+
+// Fixed-size, power-of-two hash table of search results shared by all search threads.
+//
+// Each entry is two 64-bit words written without locks: the packed data and the
+// key XORed with that data. A reader accepts an entry only if (stored ^ data) gives
+// back its own key, so a torn write from a racing thread reads as a miss rather
+// than as another position's result.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t megabytes = 16) { Resize(megabytes); }
+
+    // Rounds down to a power of two number of 64-byte buckets; clears the table
+    void Resize(size_t megabytes) {
+        size_t buckets = 1;
+        while (buckets * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024) buckets *= 2;
+        table.reset(new Bucket[buckets]);
+        mask = buckets - 1;
+        Clear();
+    }
+
+    void Clear() {
+        for (size_t i = 0; i <= mask; i++) {
+            for (Entry& e : table[i].entries) {
+                e.check.store(0, std::memory_order_relaxed);
+                e.data.store(0, std::memory_order_relaxed);
+            }
+        }
+        generation = 0;
+    }
+
+    // Call once per search so entries from older searches are replaced first
+    void NewSearch() { generation = (generation + 1) & 63; }
+
+    size_t SizeBytes() const { return (mask + 1) * sizeof(Bucket); }
+
+    bool Probe(Key key, TTData& out) const {
+        const Bucket& bucket = table[key & mask];
+        for (const Entry& e : bucket.entries) {
+            uint64_t data = e.data.load(std::memory_order_relaxed);
+            if ((e.check.load(std::memory_order_relaxed) ^ data) == key && data) {
+                out = Unpack(data);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Depth-preferred replacement: same position, else an empty slot, else the
+    // shallowest entry, counting entries from older searches as shallower
+    void Store(Key key, Move move, int score, int depth, Bound bound) {
+        Bucket& bucket = table[key & mask];
+        Entry* replace = &bucket.entries[0];
+        int worst = 1 << 30;
+        for (Entry& e : bucket.entries) {
+            uint64_t data = e.data.load(std::memory_order_relaxed);
+            if (!data || (e.check.load(std::memory_order_relaxed) ^ data) == key) {
+                if (data) {
+                    TTData old = Unpack(data);
+                    // Keep a deeper result for the same position unless the new one is exact
+                    if (bound != BoundExact && old.depth > depth + 2) return;
+                    if (move == NullMove) move = old.move;
+                }
+                replace = &e;
+                break;
+            }
+            int age = (generation - int((data >> 42) & 63)) & 63;
+            int value = int((data >> 32) & 0xFF) - 8 * age;
+            if (value < worst) {
+                worst = value;
+                replace = &e;
+            }
+        }
+        uint64_t data = Pack(move, score, depth, bound);
+        replace->data.store(data, std::memory_order_relaxed);
+        replace->check.store(key ^ data, std::memory_order_relaxed);
+    }
+
+    // Permille of the first thousand entries written by the current search
+    int Hashfull() const {
+        int used = 0;
+        size_t count = mask + 1 < 250 ? mask + 1 : 250;
+        for (size_t i = 0; i < count; i++) {
+            for (const Entry& e : table[i].entries) {
+                uint64_t data = e.data.load(std::memory_order_relaxed);
+                if (data && int((data >> 42) & 63) == generation) used++;
+            }
+        }
+        return int(used * 1000 / (count * 4));
+    }
+
+private:
+    struct Entry {
+        std::atomic<uint64_t> check{0};  // key ^ data
+        std::atomic<uint64_t> data{0};
+    };
+
+    struct alignas(64) Bucket {
+        Entry entries[4];
+    };
+
+    std::unique_ptr<Bucket[]> table;
+    size_t mask = 0;
+    std::atomic<int> generation{0}; // Only advanced between searches
+
+    // bits 0-15 move, 16-31 score, 32-39 depth, 40-41 bound, 42-47 generation
+    uint64_t Pack(Move move, int score, int depth, Bound bound) const {
+        return uint64_t(move) | (uint64_t(uint16_t(int16_t(score))) << 16) |
+               (uint64_t(uint8_t(depth)) << 32) | (uint64_t(bound) << 40) |
+               (uint64_t(generation) << 42);
+    }
+
+    static TTData Unpack(uint64_t data) {
+        TTData out;
+        out.move = Move(data & 0xFFFF);
+        out.score = int16_t(uint16_t(data >> 16));
+        out.depth = int((data >> 32) & 0xFF);
+        out.bound = Bound((data >> 40) & 3);
+        return out;
+    }
+};
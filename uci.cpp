@@ -0,0 +1,272 @@
+// UCI front end for tournament managers, test harnesses and batch analysis.
+// Headless: no raylib, no window, starts in milliseconds.
+// Build: g++ -O2 -std=c++17 uci.cpp -o chess-uci -pthread
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "fen.h"
+#include "game.h"
+#include "polyglot.h"
+#include "search.h"
+
+std::mutex outputMutex;
+
+// Every line to the GUI goes through here; search threads report concurrently
+void Send(const std::string& line) {
+    std::lock_guard<std::mutex> lock(outputMutex);
+    fputs(line.c_str(), stdout);
+    fputc('\n', stdout);
+    fflush(stdout);
+}
+
+std::string FormatScore(int score) {
+    if (score >= MateBound) return "mate " + std::to_string((MateScore - score + 1) / 2);
+    if (score <= -MateBound) return "mate -" + std::to_string((MateScore + score) / 2);
+    return "cp " + std::to_string(score);
+}
+
+// Principal variation read back from the transposition table
+std::string ExtractPv(Position pos, Move best, const TranspositionTable& tt, int maxLength) {
+    std::string pv;
+    Move m = best;
+    for (int i = 0; i < maxLength && m != NullMove; i++) {
+        MoveList legal;
+        GenerateMoves(pos, legal);
+        if (FindMove(legal, MoveFrom(m), MoveTo(m), IsPromotion(m) ? PromotionType(m) : Queen) != m) break;
+        if (!pv.empty()) pv += ' ';
+        pv += MoveToUci(m);
+        UndoInfo undo;
+        MakeMove(pos, m, undo);
+        TTData entry;
+        m = tt.Probe(pos.key, entry) ? entry.move : NullMove;
+    }
+    return pv;
+}
+
+class UciEngine {
+public:
+    UciEngine() : tt(16), pool(tt, 1) {
+        Position start;
+        start.SetStartPosition();
+        game.Reset(start);
+        pool.SetInfoCallback([this](const SearchInfo& info) {
+            int64_t nps = info.timeMs > 0 ? int64_t(info.nodes * 1000 / info.timeMs) : 0;
+            Send("info depth " + std::to_string(info.depth) + " score " + FormatScore(info.score) +
+                 " nodes " + std::to_string(info.nodes) + " nps " + std::to_string(nps) +
+                 " time " + std::to_string(info.timeMs) + " hashfull " + std::to_string(tt.Hashfull()) +
+                 " pv " + ExtractPv(searchRoot, info.bestMove, tt, info.depth));
+        });
+    }
+
+    ~UciEngine() { StopSearch(); }
+
+    void Loop() {
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            std::istringstream in(line);
+            std::string command;
+            in >> command;
+
+            if (command == "uci") {
+                Send("id name Chess");
+                Send("id author the chess-game contributors");
+                Send("option name Hash type spin default 16 min 1 max 65536");
+                Send("option name Threads type spin default 1 min 1 max 1024");
+                Send("option name UseNNUE type check default false");
+                Send("option name EvalFile type string default <builtin>");
+                Send("option name OwnBook type check default false");
+                Send("option name BookFile type string default <empty>");
+                Send("option name TablebasePath type string default <empty>");
+                Send("uciok");
+            } else if (command == "isready") {
+                Send("readyok");
+            } else if (command == "setoption") {
+                SetOption(in);
+            } else if (command == "ucinewgame") {
+                StopSearch();
+                tt.Clear();
+            } else if (command == "position") {
+                SetPosition(in);
+            } else if (command == "go") {
+                Go(in);
+            } else if (command == "stop") {
+                StopSearch();
+            } else if (command == "quit") {
+                break;
+            }
+        }
+    }
+
+private:
+    TranspositionTable tt;
+    SearchPool pool;
+    NnueNetwork network;
+    bool useNnue = false;
+    std::string evalFile = "<builtin>";
+    PolyglotBook book;
+    bool ownBook = false;
+    std::string bookFile;
+    uint64_t bookSeed = uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
+    std::unique_ptr<Tablebase> tablebase;
+    Game game;
+    Position searchRoot;
+    std::thread reporter;
+    std::atomic<bool> stopRequested{false};
+
+    // "setoption name <id> value <x>"
+    void SetOption(std::istringstream& in) {
+        std::string token, name, value;
+        in >> token; // "name"
+        while (in >> token && token != "value") name += (name.empty() ? "" : " ") + token;
+        std::getline(in >> std::ws, value); // File paths may contain spaces
+        StopSearch();
+        if (name == "Hash") tt.Resize(std::max(1, atoi(value.c_str())));
+        else if (name == "Threads") pool.SetThreads(std::max(1, atoi(value.c_str())));
+        else if (name == "UseNNUE") useNnue = value == "true";
+        else if (name == "EvalFile") evalFile = value;
+        else if (name == "OwnBook") ownBook = value == "true";
+        else if (name == "BookFile") bookFile = value == "<empty>" ? "" : value;
+        else if (name == "TablebasePath") LoadTablebase(value == "<empty>" ? "" : value);
+        else return;
+        if (name == "UseNNUE" || name == "EvalFile") LoadNetwork();
+        if (name == "OwnBook" || name == "BookFile") LoadBook();
+    }
+
+    void LoadBook() {
+        book.Close();
+        if (!ownBook || bookFile.empty()) return;
+        if (book.Open(bookFile.c_str())) {
+            Send("info string book " + bookFile + " with " + std::to_string(book.Size()) + " entries");
+        } else {
+            Send("info string cannot open book " + bookFile);
+        }
+    }
+
+    void LoadTablebase(const std::string& dir) {
+        pool.SetTablebase(nullptr);
+        tablebase.reset();
+        if (dir.empty()) return;
+        tablebase.reset(new Tablebase);
+        int count = tablebase->Load(dir);
+        if (count == 0) {
+            Send("info string no tablebase files in " + dir);
+            tablebase.reset();
+            return;
+        }
+        pool.SetTablebase(tablebase.get());
+        Send("info string " + std::to_string(count) + " tablebase files up to " +
+             std::to_string(tablebase->MaxPieces()) + " pieces in " + dir);
+    }
+
+    // Scores from the two evaluations do not mix, so switching also clears the hash table
+    void LoadNetwork() {
+        pool.SetNetwork(nullptr);
+        tt.Clear();
+        if (!useNnue) return;
+        if (evalFile.empty() || evalFile == "<builtin>") {
+            network.LoadBuiltin();
+        } else if (!network.Load(evalFile.c_str())) {
+            Send("info string cannot load " + evalFile + ", using the classical evaluation");
+            return;
+        }
+        pool.SetNetwork(&network);
+        Send("info string NNUE evaluation using " + evalFile + " (" + network.Kernels().name + ")");
+    }
+
+    // "position [startpos | fen <fen>] [moves <m1> ...]"
+    void SetPosition(std::istringstream& in) {
+        StopSearch();
+        std::string token, fen;
+        in >> token;
+        Position start;
+        if (token == "startpos") {
+            start.SetStartPosition();
+            in >> token;
+        } else if (token == "fen") {
+            while (in >> token && token != "moves") fen += (fen.empty() ? "" : " ") + token;
+            if (!ParseFen(fen, start)) {
+                Send("info string invalid fen");
+                return;
+            }
+        } else {
+            return;
+        }
+        game.Reset(start);
+        if (token != "moves") return;
+        while (in >> token) {
+            Move m = ParseUciMove(game.pos, token);
+            if (m == NullMove) {
+                Send("info string illegal move " + token);
+                return;
+            }
+            game.Play(m);
+        }
+    }
+
+    // "go [depth d] [nodes n] [movetime ms] [wtime ms btime ms winc ms binc ms movestogo n] [infinite]"
+    void Go(std::istringstream& in) {
+        StopSearch();
+        SearchLimits limits;
+        int64_t time[2] = {0, 0}, inc[2] = {0, 0};
+        int movesToGo = 0;
+        bool infinite = false;
+        std::string token;
+        while (in >> token) {
+            if (token == "depth") in >> limits.depth;
+            else if (token == "nodes") in >> limits.nodes;
+            else if (token == "movetime") in >> limits.movetimeMs;
+            else if (token == "wtime") in >> time[White];
+            else if (token == "btime") in >> time[Black];
+            else if (token == "winc") in >> inc[White];
+            else if (token == "binc") in >> inc[Black];
+            else if (token == "movestogo") in >> movesToGo;
+            else if (token == "infinite") infinite = true;
+        }
+        if (limits.depth < 1 || limits.depth >= MaxPly) limits.depth = MaxPly - 1;
+
+        // Clock play: a share of the remaining time plus most of the increment
+        Side us = game.pos.sideToMove;
+        if (!infinite && !limits.movetimeMs && time[us] > 0) {
+            int64_t budget = time[us] / (movesToGo > 0 ? movesToGo + 1 : 30) + inc[us] * 3 / 4;
+            int64_t safety = std::min<int64_t>(50, time[us] / 10);
+            limits.movetimeMs = std::max<int64_t>(1, std::min(budget, time[us] - safety));
+        }
+
+        // A book move is answered at once; infinite analysis still searches
+        if (ownBook && book.Loaded() && !infinite) {
+            Move bookMove = book.Pick(game.pos, SplitMix64(bookSeed));
+            if (bookMove != NullMove) {
+                Send("bestmove " + MoveToUci(bookMove));
+                return;
+            }
+        }
+
+        searchRoot = game.pos;
+        stopRequested = false;
+        pool.Start(game.pos, game.keys, limits);
+        reporter = std::thread([this, infinite] {
+            SearchResult result = pool.Wait();
+            // In infinite mode bestmove may only be sent after "stop"
+            while (infinite && !stopRequested) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            Send("bestmove " + MoveToUci(result.bestMove));
+        });
+    }
+
+    void StopSearch() {
+        stopRequested = true;
+        pool.Stop();
+        if (reporter.joinable()) reporter.join();
+    }
+};
+
+int main() {
+    std::ios::sync_with_stdio(false);
+    UciEngine engine;
+    engine.Loop();
+    return 0;
+}
@@ -0,0 +1,338 @@
+#pragma once
+#include <cstdio>
+#include <ctime>
+#include <sstream>
+#include <string>
+#include "eval.h"
+#include "game.h"
+#include "pgn.h"
+#include "playout.h"
+#include "polyglot.h"
+#include "search.h"
+
+// The GUI's behaviour as a state machine advanced once per frame. It knows nothing
+// about raylib: the frame loop turns mouse and keyboard into a UiInput, calls Update,
+// and draws whatever the state says. Overlays such as the promotion choice and the
+// game-over screen are modes of the same machine rather than nested loops, so the
+// engine keeps being polled and scripted input can drive the whole UI headless.
+
+enum class UiMode {
+    Playing,
+    Promoting,  // Waiting for the promotion piece of a pawn move
+    GameOver,   // Showing the result until ENTER starts a new game
+    Quit
+};
+
+enum UiKey {
+    UiKeyNone,
+    UiKeyEnter,
+    UiKeyEscape,
+    UiKeyUp,
+    UiKeyDown,
+    UiKeyQueen,   // 1
+    UiKeyRook,    // 2
+    UiKeyBishop,  // 3
+    UiKeyKnight,  // 4
+    UiKeySave,    // S
+    UiKeyHints,   // H
+    UiKeyProfile  // P
+};
+
+// Everything the user did in one frame
+struct UiInput {
+    int click = NoSquare;  // Square clicked with the left button
+    UiKey key = UiKeyNone;
+};
+
+// Indexed by the promotion choice shown in the overlay
+const PieceType PromotionChoices[4] = {Queen, Rook, Bishop, Knight};
+
+inline const char* ResultString(GameOutcome outcome) {
+    switch (outcome) {
+        case WhiteWins: return "1-0";
+        case BlackWins: return "0-1";
+        case Draw: return "1/2-1/2";
+        default: return "*";
+    }
+}
+
+// Append the game so far to a PGN file
+inline bool SaveGame(const char* path, const Game& game, bool engineWhite, bool engineBlack, const char* result) {
+    char date[16];
+    time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y.%m.%d", localtime(&now));
+    std::vector<PgnTag> tags = {
+        {"Event", "Casual game"}, {"Site", "?"}, {"Date", date}, {"Round", "-"},
+        {"White", engineWhite ? "Engine" : "Human"}, {"Black", engineBlack ? "Engine" : "Human"},
+        {"Result", result},
+    };
+    std::string text;
+    WritePgn(text, tags, game, result);
+    FILE* file = fopen(path, "a");
+    if (!file) return false;
+    bool ok = fwrite(text.data(), 1, text.size(), file) == text.size();
+    return fclose(file) == 0 && ok;
+}
+
+class ChessUi {
+public:
+    ChessUi(const Game& initialGame, SearchPool& engine, const SearchLimits& engineLimits,
+            bool engineWhite, bool engineBlack)
+        : initialGame(initialGame), engine(engine), engineLimits(engineLimits),
+          engineWhite(engineWhite), engineBlack(engineBlack) {
+        NewGame();
+    }
+
+    // Evaluate with a network for the on-screen score; nullptr hides it
+    void SetNetwork(const NnueNetwork* network) {
+        nnue = network;
+        PositionChanged();
+    }
+    void SetSavePath(const char* path) { savePath = path; }
+
+    // Show the perfect-play verdict of tabled positions; nullptr hides it
+    void SetTablebase(const Tablebase* tables) {
+        tablebase = tables;
+        PositionChanged();
+    }
+
+    // Keep a playout estimate of the current position running; nullptr for none
+    void SetPlayouts(PlayoutPool* pool) {
+        playouts = pool;
+        PositionChanged();
+    }
+
+    // Play the engine's moves from an opening book while it has any; `seed` picks
+    // among weighted alternatives, so a fixed seed replays the same openings
+    void SetBook(const PolyglotBook* openingBook, uint64_t seed) {
+        book = openingBook;
+        bookSeed = seed;
+    }
+
+    void NewGame() {
+        // The position is a flat value copy and the history vectors keep their capacity
+        game = initialGame;
+        mode = UiMode::Playing;
+        selected = NoSquare;
+        moveCounter = 0;
+        saveMessage = nullptr;
+        PositionChanged();
+    }
+
+    // Advance one frame
+    void Update(const UiInput& input) {
+        PROFILE_SCOPE(ProfileUiUpdate);
+        if (input.key == UiKeyProfile) showProfile = !showProfile;  // In every mode
+        switch (mode) {
+            case UiMode::Playing: UpdatePlaying(input); break;
+            case UiMode::Promoting: UpdatePromoting(input); break;
+            case UiMode::GameOver:
+                if (input.key == UiKeyEnter) NewGame();
+                else if (input.key == UiKeyEscape) mode = UiMode::Quit;
+                else if (input.key == UiKeySave) Save();
+                break;
+            case UiMode::Quit: break;
+        }
+    }
+
+    UiMode Mode() const { return mode; }
+    const Game& CurrentGame() const { return game; }
+    const Position& Pos() const { return game.pos; }
+    const GameStatus& Status() const { return status; }
+    bool EngineTurn() const { return mode == UiMode::Playing && (Pos().sideToMove == White ? engineWhite : engineBlack); }
+
+    int Selected() const { return selected; }
+    const MoveList& SelectedMoves() const { return selectedMoves; }  // The dots to draw
+    int PromotionChoice() const { return promotionChoice; }
+    int MoveCounter() const { return moveCounter; }
+    bool ShowPawnHints() const { return showPawnHints; }
+    bool ShowProfile() const { return showProfile; }
+    const char* SaveMessage() const { return saveMessage; }
+    bool HasNnueScore() const { return nnue != nullptr; }
+    int NnueScore() const { return nnueScore; }  // White's point of view
+    const std::string& TablebaseVerdict() const { return tbVerdict; }  // Empty when not tabled
+    const PlayoutPool* Playouts() const { return playouts; }
+
+    // True once after anything on the cached board layer changed
+    bool TakeBoardDirty() {
+        bool dirty = boardDirty;
+        boardDirty = false;
+        return dirty;
+    }
+
+private:
+    Game initialGame;
+    Game game;
+    SearchPool& engine;
+    SearchLimits engineLimits;
+    bool engineWhite, engineBlack;
+    const NnueNetwork* nnue = nullptr;
+    const char* savePath = "game.pgn";
+    const PolyglotBook* book = nullptr;
+    uint64_t bookSeed = 0;
+    const Tablebase* tablebase = nullptr;
+    PlayoutPool* playouts = nullptr;
+
+    UiMode mode = UiMode::Playing;
+    // Everything derived from the position is recomputed only when a move is made
+    MoveList legalMoves;
+    GameStatus status = {Ongoing, nullptr};
+    int nnueScore = 0;
+    std::string tbVerdict;
+    bool boardDirty = true;
+    int selected = NoSquare;
+    MoveList selectedMoves;
+    int promotionFrom = NoSquare, promotionTo = NoSquare;
+    int promotionChoice = 0;
+    int moveCounter = 0;
+    bool showPawnHints = false;
+    bool showProfile = false;
+    const char* saveMessage = nullptr;
+
+    void PositionChanged() {
+        const Position& pos = game.pos;
+        legalMoves.Clear();
+        GenerateMoves(pos, legalMoves);
+        status = game.Status(legalMoves);
+        if (nnue) {
+            nnueScore = nnue->Evaluate(pos);
+            if (pos.sideToMove == Black) nnueScore = -nnueScore;
+        }
+        uint8_t tbValue;
+        tbVerdict.clear();
+        if (tablebase && status.outcome == Ongoing && tablebase->Probe(pos, tbValue)) {
+            tbVerdict = "Tablebase: " + TbVerdict(pos.sideToMove, tbValue);
+        }
+        if (playouts) {
+            if (status.outcome == Ongoing) playouts->Start(pos);
+            else playouts->Stop();
+        }
+        boardDirty = true;
+        if (status.outcome != Ongoing) mode = UiMode::GameOver;
+    }
+
+    void Play(Move m) {
+        game.Play(m);
+        moveCounter++;
+        PositionChanged();
+    }
+
+    void Save() {
+        saveMessage = SaveGame(savePath, game, engineWhite, engineBlack, ResultString(status.outcome))
+                    ? "Game saved" : "Save failed";
+    }
+
+    void UpdatePlaying(const UiInput& input) {
+        // Engine move: start a search on its turn, play the move once it is done
+        bool engineTurn = EngineTurn();
+        if (engineTurn) {
+            if (engine.IsDone()) {
+                Play(engine.Wait().bestMove);
+                if (mode != UiMode::Playing) return;
+            } else if (!engine.IsRunning()) {
+                Move bookMove = book ? book->Pick(game.pos, SplitMix64(bookSeed)) : NullMove;
+                if (bookMove != NullMove) {
+                    Play(bookMove);
+                    if (mode != UiMode::Playing) return;
+                } else {
+                    engine.Start(game.pos, game.keys, engineLimits);
+                }
+            }
+        }
+
+        switch (input.key) {
+            case UiKeyHints:
+                showPawnHints = !showPawnHints;
+                boardDirty = true;
+                break;
+            case UiKeySave: Save(); break;
+            case UiKeyEscape: mode = UiMode::Quit; return;
+            default: break;
+        }
+
+        if (input.click == NoSquare || engineTurn) return;
+        if (selected == NoSquare) {
+            // Select piece and collect its moves once, not every frame
+            Piece p = game.pos.PieceOn(input.click);
+            if (p != NoPiece && SideOf(p) == game.pos.sideToMove) {
+                selected = input.click;
+                selectedMoves.Clear();
+                for (Move m : legalMoves) {
+                    if (MoveFrom(m) == selected) selectedMoves.Add(m);
+                }
+            }
+            return;
+        }
+
+        // Castling, en passant and promotion are all just entries in the legal list
+        Move move = FindMove(selectedMoves, selected, input.click);
+        if (move != NullMove && IsPromotion(move)) {
+            promotionFrom = selected;
+            promotionTo = input.click;
+            promotionChoice = 0;
+            mode = UiMode::Promoting;
+        } else if (move != NullMove) {
+            Play(move);
+        }
+        selected = NoSquare;
+    }
+
+    void UpdatePromoting(const UiInput& input) {
+        switch (input.key) {
+            case UiKeyQueen: promotionChoice = 0; break;
+            case UiKeyRook: promotionChoice = 1; break;
+            case UiKeyBishop: promotionChoice = 2; break;
+            case UiKeyKnight: promotionChoice = 3; break;
+            case UiKeyUp: promotionChoice = (promotionChoice + 3) % 4; break;
+            case UiKeyDown: promotionChoice = (promotionChoice + 1) % 4; break;
+            case UiKeyEscape: mode = UiMode::Playing; break;  // Take the pawn move back
+            case UiKeyEnter:
+                mode = UiMode::Playing;
+                Play(FindMove(legalMoves, promotionFrom, promotionTo, PromotionChoices[promotionChoice]));
+                break;
+            default: break;
+        }
+    }
+};
+
+// Scripted input, one command per line, for driving the UI without a mouse:
+//   click e2      a left click on a square
+//   key NAME      enter, escape, up, down, 1-4, s, h or p
+//   wait          idle frames until the engine has made its move
+// Blank lines and lines starting with # are ignored. Returns false on a bad line.
+struct UiScriptStep {
+    UiInput input;
+    bool waitForEngine = false;
+};
+
+inline bool ParseUiScriptLine(const std::string& line, UiScriptStep& step, bool& empty) {
+    std::istringstream in(line);
+    std::string command, arg;
+    step = UiScriptStep();
+    empty = !(in >> command) || command[0] == '#';
+    if (empty) return true;
+    in >> arg;
+    if (command == "wait") {
+        step.waitForEngine = true;
+        return true;
+    }
+    if (command == "click") {
+        if (arg.size() != 2 || arg[0] < 'a' || arg[0] > 'h' || arg[1] < '1' || arg[1] > '8') return false;
+        step.input.click = MakeSquare(arg[0] - 'a', arg[1] - '1');
+        return true;
+    }
+    if (command == "key") {
+        static const struct { const char* name; UiKey key; } keys[] = {
+            {"enter", UiKeyEnter}, {"escape", UiKeyEscape}, {"up", UiKeyUp}, {"down", UiKeyDown},
+            {"1", UiKeyQueen}, {"2", UiKeyRook}, {"3", UiKeyBishop}, {"4", UiKeyKnight},
+            {"s", UiKeySave}, {"h", UiKeyHints}, {"p", UiKeyProfile},
+        };
+        for (const auto& k : keys) {
+            if (arg == k.name) {
+                step.input.key = k.key;
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include "piece.h"
+
+typedef uint64_t Key;
+
+// Random keys XORed together into a 64-bit position hash, generated at compile time
+struct ZobristKeys {
+    Key piece[PieceCount][64];
+    Key castling[16];  // One per castling-rights combination
+    Key epFile[8];
+    Key side;          // Present when black is to move
+};
+
+constexpr uint64_t SplitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys MakeZobristKeys() {
+    ZobristKeys keys = {};
+    uint64_t state = 0x2545F4914F6CDD1DULL;
+    for (auto& piece : keys.piece) {
+        for (auto& sq : piece) sq = SplitMix64(state);
+    }
+    // Rights combine by XOR, so each combination is the XOR of its single-right keys
+    Key single[4] = {SplitMix64(state), SplitMix64(state), SplitMix64(state), SplitMix64(state)};
+    for (int rights = 0; rights < 16; rights++) {
+        for (int bit = 0; bit < 4; bit++) {
+            if (rights & (1 << bit)) keys.castling[rights] ^= single[bit];
+        }
+    }
+    for (auto& file : keys.epFile) file = SplitMix64(state);
+    keys.side = SplitMix64(state);
+    return keys;
+}
+
+inline constexpr ZobristKeys Zobrist = MakeZobristKeys();